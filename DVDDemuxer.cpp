@@ -0,0 +1,811 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <media/MediaFormats.h>
+
+#include "DVDDemuxer.h"
+
+#define TOUCH(x) ((void)(x))
+
+#define PRINTF(a,b) \
+        do { \
+            if (a < 2) { \
+                printf("DVDDemuxer::"); \
+                printf b; \
+            } \
+        } while (0)
+
+/* How long a decoder waits for its stream before giving up on a chunk */
+#define DVD_CHUNK_TIMEOUT 1000000
+
+
+/* DVDStreamRing */
+
+DVDStreamRing::DVDStreamRing(size_t size)
+  : fData(NULL),
+    fSize(sizeof(dvd_chunk)),
+    fHead(0),
+    fTail(0),
+    fDataSem(-1),
+    fSpaceSem(-1),
+    fDataWaiting(0),
+    fSpaceWaiting(0),
+    fReaderWoken(0),
+    fDiscardHead(0),
+    fDiscards(0),
+    fDiscardsSeen(0)
+{
+    // The counters wrap around, so the size has to divide 2^32
+    while (fSize < size)
+        fSize <<= 1;
+
+    fData = (uint8 *)malloc(fSize);
+    fDataSem = create_sem(0, "dvd stream data");
+    fSpaceSem = create_sem(0, "dvd stream space");
+}
+
+
+DVDStreamRing::~DVDStreamRing()
+{
+    delete_sem(fDataSem);
+    delete_sem(fSpaceSem);
+    free(fData);
+}
+
+
+status_t
+DVDStreamRing::InitCheck() const
+{
+    if (fData == NULL)
+        return B_NO_MEMORY;
+    if (fDataSem < B_OK)
+        return fDataSem;
+    if (fSpaceSem < B_OK)
+        return fSpaceSem;
+
+    return B_OK;
+}
+
+
+/* Chunks start on a header boundary, so a header never wraps. */
+size_t
+DVDStreamRing::_ChunkSize(size_t size) const
+{
+    size += 2 * sizeof(dvd_chunk) - 1;
+    return size - size % sizeof(dvd_chunk);
+}
+
+
+bool
+DVDStreamRing::Write(const uint8 *data, size_t size, int64 pts, uint32 flags)
+{
+    uint32 head = fHead;
+    uint32 tail = atomic_get(&fTail);
+    size_t need = _ChunkSize(size);
+    size_t offset = head & (fSize - 1);
+    size_t pad = 0;
+
+    // A chunk that doesn't fit before the end starts over at the beginning
+    if (fSize - offset < need)
+        pad = fSize - offset;
+
+    if (fSize - (head - tail) < need + pad)
+        return false;
+
+    if (pad > 0) {
+        dvd_chunk *skip = (dvd_chunk *)(fData + offset);
+        skip->size = 0;
+        skip->flags = DVD_CHUNK_SKIP;
+        skip->pts = 0;
+        head += pad;
+        offset = 0;
+    }
+
+    dvd_chunk *chunk = (dvd_chunk *)(fData + offset);
+    chunk->size = size;
+    chunk->flags = flags;
+    chunk->pts = pts;
+    memcpy(chunk + 1, data, size);
+
+    atomic_set(&fHead, head + need);
+    _Wake(&fDataWaiting, fDataSem);
+
+    return true;
+}
+
+
+const dvd_chunk *
+DVDStreamRing::Peek()
+{
+    uint32 tail = fTail;
+
+    while (tail != (uint32)atomic_get(&fHead)) {
+        dvd_chunk *chunk = (dvd_chunk *)(fData + (tail & (fSize - 1)));
+        if ((chunk->flags & DVD_CHUNK_SKIP) == 0)
+            return chunk;
+
+        tail += fSize - (tail & (fSize - 1));
+        atomic_set(&fTail, tail);
+    }
+
+    return NULL;
+}
+
+
+void
+DVDStreamRing::Consume()
+{
+    const dvd_chunk *chunk = Peek();
+    if (chunk == NULL)
+        return;
+
+    atomic_set(&fTail, fTail + _ChunkSize(chunk->size));
+    _Wake(&fSpaceWaiting, fSpaceSem);
+}
+
+
+status_t
+DVDStreamRing::WaitForData(bigtime_t timeout)
+{
+    return _Wait(&fDataWaiting, fDataSem, timeout, false);
+}
+
+
+status_t
+DVDStreamRing::WaitForSpace(bigtime_t timeout)
+{
+    return _Wait(&fSpaceWaiting, fSpaceSem, timeout, true);
+}
+
+
+void
+DVDStreamRing::WakeReader()
+{
+    atomic_set(&fReaderWoken, 1);
+    _Wake(&fDataWaiting, fDataSem);
+}
+
+
+/* Can be called while the consumer is running, the producer just must not
+ * write at the same time. */
+void
+DVDStreamRing::Discard()
+{
+    atomic_set(&fDiscardHead, atomic_get(&fHead));
+    atomic_add(&fDiscards, 1);
+}
+
+
+/* Returns true if the consumer was moved past chunks dropped by
+ * Discard(). The tail only moves forward, the consumer may have read new
+ * chunks already. */
+bool
+DVDStreamRing::CatchUp()
+{
+    int32 discards = atomic_get(&fDiscards);
+    if (discards == fDiscardsSeen)
+        return false;
+
+    fDiscardsSeen = discards;
+
+    uint32 head = atomic_get(&fDiscardHead);
+    if ((int32)(head - (uint32)fTail) < 0)
+        return false;
+
+    atomic_set(&fTail, head);
+    _Wake(&fSpaceWaiting, fSpaceSem);
+    return true;
+}
+
+
+void
+DVDStreamRing::Flush()
+{
+    atomic_set(&fHead, 0);
+    atomic_set(&fTail, 0);
+    atomic_set(&fDiscardHead, 0);
+    atomic_set(&fReaderWoken, 0);
+    fDiscardsSeen = atomic_get(&fDiscards);
+}
+
+
+size_t
+DVDStreamRing::Used()
+{
+    return (uint32)atomic_get(&fHead) - (uint32)atomic_get(&fTail);
+}
+
+
+void
+DVDStreamRing::_Wake(int32 *waiting, sem_id sem)
+{
+    if (atomic_get(waiting) != 0 && atomic_set(waiting, 0) != 0)
+        release_sem_etc(sem, 1, B_DO_NOT_RESCHEDULE);
+}
+
+
+/* Announces the wait first and checks again afterwards, so a wake-up from
+ * the other side can't slip in between. Spurious returns are possible,
+ * callers check again. */
+status_t
+DVDStreamRing::_Wait(int32 *waiting, sem_id sem, bigtime_t timeout,
+    bool forSpace)
+{
+    atomic_set(waiting, 1);
+
+    bool ready = forSpace ? Used() < fSize / 2 : Used() > 0;
+    if (ready) {
+        atomic_set(waiting, 0);
+        return B_OK;
+    }
+
+    if (!forSpace && atomic_set(&fReaderWoken, 0) != 0) {
+        atomic_set(waiting, 0);
+        return B_CANCELED;
+    }
+
+    status_t status = acquire_sem_etc(sem, 1, B_RELATIVE_TIMEOUT, timeout);
+    if (status != B_OK)
+        atomic_set(waiting, 0);
+
+    if (!forSpace && atomic_set(&fReaderWoken, 0) != 0)
+        return B_CANCELED;
+
+    return status;
+}
+
+
+/* DVDDemuxer */
+
+DVDDemuxer::DVDDemuxer(dvdnav_t *nav)
+  : fDVDNav(nav),
+    fBlocked(NULL),
+    fTimeOffset(0),
+    fLastEnd(-1)
+{
+    memset(fRings, 0, sizeof(fRings));
+}
+
+
+DVDDemuxer::~DVDDemuxer()
+{
+    for (int32 i = 0; i < DVD_STREAM_COUNT; i++)
+        delete fRings[i];
+}
+
+
+/* Must not be called while Demux() runs. */
+status_t
+DVDDemuxer::EnableStream(int32 stream)
+{
+    if (stream < 0 || stream >= DVD_STREAM_COUNT)
+        return B_BAD_INDEX;
+
+    if (fRings[stream] != NULL)
+        return B_OK;
+
+    size_t size = DVD_SPU_RING_SIZE;
+    if (stream == DVD_STREAM_VIDEO)
+        size = DVD_VIDEO_RING_SIZE;
+    else if (stream < DVD_STREAM_SPU)
+        size = DVD_AUDIO_RING_SIZE;
+
+    DVDStreamRing *ring = new DVDStreamRing(size);
+    status_t status = ring->InitCheck();
+    if (status != B_OK) {
+        delete ring;
+        return status;
+    }
+
+    fRings[stream] = ring;
+    return B_OK;
+}
+
+
+DVDStreamRing *
+DVDDemuxer::StreamAt(int32 stream) const
+{
+    if (stream < 0 || stream >= DVD_STREAM_COUNT)
+        return NULL;
+
+    return fRings[stream];
+}
+
+
+ssize_t
+DVDDemuxer::Demux(const uint8 *blocks, size_t length)
+{
+    size_t done = 0;
+
+    fBlocked = NULL;
+
+    for (; done + DVD_VIDEO_LB_LEN <= length; done += DVD_VIDEO_LB_LEN) {
+        dvdnav_pes_packet_t pes;
+
+        if (dvdnav_get_pes_packet(fDVDNav, blocks + done, &pes)
+                != DVDNAV_STATUS_OK) {
+            PRINTF(2, ("Demux(): %s\n", dvdnav_err_to_string(fDVDNav)));
+            continue;
+        }
+
+        // The PCI of a NAV packet gives the time span of its VOBU
+        if (pes.stream_id == 0xbf && pes.payload_length > 20
+            && pes.payload[0] == 0x00)
+            _Retime(pes.payload + 1);
+
+        DVDStreamRing *ring = StreamAt(StreamFor(pes));
+        if (ring == NULL || pes.payload_length == 0)
+            continue;
+
+        if (pes.has_pts && fLastEnd < 0) {
+            fTimeOffset = pes.pts;
+            fLastEnd = pes.pts;
+        }
+
+        if (!ring->Write(pes.payload, pes.payload_length,
+                pes.pts - fTimeOffset, pes.has_pts ? DVD_CHUNK_PTS : 0)) {
+            fBlocked = ring;
+            break;
+        }
+    }
+
+    return done;
+}
+
+
+/* Waits until the ring that stopped the last Demux() call has room again. */
+status_t
+DVDDemuxer::WaitForSpace(bigtime_t timeout)
+{
+    if (fBlocked == NULL)
+        return B_OK;
+
+    return fBlocked->WaitForSpace(timeout);
+}
+
+
+/* Must not be called while Demux() runs or a decoder reads. */
+void
+DVDDemuxer::Flush()
+{
+    for (int32 i = 0; i < DVD_STREAM_COUNT; i++) {
+        if (fRings[i] != NULL)
+            fRings[i]->Flush();
+    }
+
+    fBlocked = NULL;
+}
+
+
+/* Drops what is in the rings while the outputs keep reading, for a jump to
+ * another position. Must not run alongside Demux(). */
+void
+DVDDemuxer::Discard()
+{
+    for (int32 i = 0; i < DVD_STREAM_COUNT; i++) {
+        if (fRings[i] != NULL)
+            fRings[i]->Discard();
+    }
+
+    fBlocked = NULL;
+    ResetTime();
+}
+
+
+/* True once the outputs have taken everything out of the rings. */
+bool
+DVDDemuxer::Drained() const
+{
+    for (int32 i = 0; i < DVD_STREAM_COUNT; i++) {
+        if (fRings[i] != NULL && fRings[i]->Used() > 0)
+            return false;
+    }
+
+    return true;
+}
+
+
+/* Lets the decoders waiting for a stream give up, the demuxer stopped. */
+void
+DVDDemuxer::WakeReaders()
+{
+    for (int32 i = 0; i < DVD_STREAM_COUNT; i++) {
+        if (fRings[i] != NULL)
+            fRings[i]->WakeReader();
+    }
+}
+
+
+/* Starts the time stamps over at 0 with the next VOBU. */
+void
+DVDDemuxer::ResetTime()
+{
+    fTimeOffset = 0;
+    fLastEnd = -1;
+}
+
+
+/* Lets the next VOBU start no earlier than 'at' (90kHz), for when the
+ * stream was held up by a still or a wait while time went on. */
+void
+DVDDemuxer::Resume(int64 at)
+{
+    if (fLastEnd < 0)
+        return;
+
+    int64 end = fLastEnd - fTimeOffset;
+    if (at > end)
+        fTimeOffset -= at - end;
+}
+
+
+/* Closes up a PTS jump between the last VOBU and this one, using the
+ * vobu_s_ptm and vobu_e_ptm of the PCI. */
+void
+DVDDemuxer::_Retime(const uint8 *pci)
+{
+    int64 start = (uint32)(pci[12] << 24 | pci[13] << 16 | pci[14] << 8
+        | pci[15]);
+    int64 end = (uint32)(pci[16] << 24 | pci[17] << 16 | pci[18] << 8
+        | pci[19]);
+
+    if (fLastEnd < 0)
+        fTimeOffset = start;
+    else if (start < fLastEnd || start - fLastEnd > DVD_MAX_PTS_GAP)
+        fTimeOffset += start - fLastEnd;
+
+    fLastEnd = end;
+}
+
+
+int32
+DVDDemuxer::StreamFor(const dvdnav_pes_packet_t &pes)
+{
+    if (pes.stream_id == 0xe0)
+        return DVD_STREAM_VIDEO;
+
+    if (pes.stream_id >= 0xc0 && pes.stream_id <= 0xc7)
+        return DVD_STREAM_AUDIO + (pes.stream_id & 0x07);
+
+    if (pes.stream_id != 0xbd)
+        return -1;
+
+    if (pes.substream_id >= 0x20 && pes.substream_id <= 0x3f)
+        return DVD_STREAM_SPU + (pes.substream_id & 0x1f);
+
+    // AC3, DTS and LPCM
+    if ((pes.substream_id >= 0x80 && pes.substream_id <= 0x8f)
+        || (pes.substream_id >= 0xa0 && pes.substream_id <= 0xa7))
+        return DVD_STREAM_AUDIO + (pes.substream_id & 0x07);
+
+    return -1;
+}
+
+
+/* Finds the stream of a logical audio stream of the current title. */
+int32
+DVDDemuxer::AudioStreamFor(dvdnav_t *nav, int32 logical)
+{
+    for (uint8 physical = 0; physical < 8; physical++) {
+        if (dvdnav_get_audio_logical_stream(nav, physical) == logical)
+            return DVD_STREAM_AUDIO + physical;
+    }
+
+    return DVD_STREAM_AUDIO + logical;
+}
+
+
+/* Describes the encoding of a logical audio stream of the current title,
+ * from its attributes in the IFO. */
+status_t
+DVDDemuxer::AudioFormatFor(dvdnav_t *nav, int32 logical, media_format *format)
+{
+    audio_attr_t attr;
+    if (dvdnav_get_audio_attr(nav, logical, &attr) != DVDNAV_STATUS_OK)
+        return B_ERROR;
+
+    uint16 encoding = dvdnav_audio_stream_format(nav, logical);
+
+    media_format_description description;
+    switch (encoding) {
+        case DVDNAV_FORMAT_AC3:
+            description.family = B_WAV_FORMAT_FAMILY;
+            description.u.wav.codec = 0x2000;
+            break;
+        case DVDNAV_FORMAT_DTS:
+            description.family = B_WAV_FORMAT_FAMILY;
+            description.u.wav.codec = 0x2001;
+            break;
+        case DVDNAV_FORMAT_MPEGAUDIO:
+            description.family = B_WAV_FORMAT_FAMILY;
+            description.u.wav.codec = 0x0050;
+            break;
+        case DVDNAV_FORMAT_LPCM:
+            // 20 and 24 bit samples are packed in their own way
+            if (attr.quantization != 0)
+                return B_NOT_SUPPORTED;
+            description.family = B_BEOS_FORMAT_FAMILY;
+            description.u.beos.format = B_BEOS_FORMAT_RAW_AUDIO;
+            break;
+        default:
+            return B_NOT_SUPPORTED;
+    }
+
+    BMediaFormats formats;
+    status_t status = formats.GetFormatFor(description, format);
+    if (status != B_OK)
+        return status;
+
+    float rate = attr.sample_frequency == 1 ? 96000 : 48000;
+    uint32 channels = attr.channels + 1;
+
+    if (encoding == DVDNAV_FORMAT_LPCM) {
+        // The frame header is gone, what is left is big endian PCM
+        format->type = B_MEDIA_RAW_AUDIO;
+        format->u.raw_audio = media_raw_audio_format::wildcard;
+        format->u.raw_audio.frame_rate = rate;
+        format->u.raw_audio.channel_count = channels;
+        format->u.raw_audio.format = media_raw_audio_format::B_AUDIO_SHORT;
+        format->u.raw_audio.byte_order = B_MEDIA_BIG_ENDIAN;
+    } else {
+        format->u.encoded_audio.output.frame_rate = rate;
+        format->u.encoded_audio.output.channel_count = channels;
+    }
+
+    return B_OK;
+}
+
+
+/* DVDStreamDecoder */
+
+/* Start code prefix, to give back the part of a start code that fell into
+ * a dropped chunk. */
+static const uint8 kStartCode[3] = { 0x00, 0x00, 0x01 };
+
+#define PICTURE_START_CODE  0x00
+#define SEQUENCE_END_CODE   0xb7
+#define SEQUENCE_START_CODE 0xb3
+#define GROUP_START_CODE    0xb8
+
+#define P_PICTURE 2
+#define B_PICTURE 3
+
+
+DVDStreamDecoder::DVDStreamDecoder(DVDStreamRing *ring,
+        const media_format *format)
+  : BMediaDecoder(format),
+    fRing(ring),
+    fChunk(NULL),
+    fOffset(0),
+    fQueued(0),
+    fCarrySize(0),
+    fCarryIndex(0),
+    fCode(0xffffffff),
+    fTypeBytes(0),
+    fDropping(false),
+    fSkipMode(DVD_SKIP_NONE),
+    fDropped(0)
+{
+}
+
+
+/* Forgets the chunk handed out last, for when the ring was flushed. */
+void
+DVDStreamDecoder::Reset()
+{
+    fChunk = NULL;
+    fOffset = 0;
+    fQueued = 0;
+    fCarrySize = 0;
+    fCode = 0xffffffff;
+    fTypeBytes = 0;
+    fDropping = false;
+}
+
+
+/* Drops everything buffered for the stream, for outputs nobody listens to,
+ * so their ring doesn't hold up the demuxer. */
+void
+DVDStreamDecoder::Skip()
+{
+    if (!fRing->CatchUp() && fChunk != NULL)
+        fRing->Consume();
+    Reset();
+
+    while (fRing->Peek() != NULL)
+        fRing->Consume();
+}
+
+
+/* Which MPEG-2 pictures to leave out before they reach the decoder: none,
+ * B pictures, which nothing refers to, or B and P pictures, so that only
+ * I pictures are decoded. Only for video streams. */
+void
+DVDStreamDecoder::SetSkipMode(int32 mode)
+{
+    atomic_set(&fSkipMode, mode);
+}
+
+
+int32
+DVDStreamDecoder::SkipMode()
+{
+    return atomic_get(&fSkipMode);
+}
+
+
+int32
+DVDStreamDecoder::CountDropped()
+{
+    return atomic_get(&fDropped);
+}
+
+
+status_t
+DVDStreamDecoder::GetNextChunk(const void **chunk, size_t *size,
+        media_header *header)
+{
+    // The decoder is done with the previous piece once it asks for the next
+    while (fQueued == 0) {
+        status_t status = _Fill(header);
+        if (status != B_OK)
+            return status;
+    }
+
+    *chunk = fQueue[0].data;
+    *size = fQueue[0].size;
+
+    fQueued--;
+    memmove(fQueue, fQueue + 1, fQueued * sizeof(fQueue[0]));
+
+    return B_OK;
+}
+
+
+/* Queues the next pieces of the stream for GetNextChunk(), leaving out the
+ * pictures the skip mode drops. Pieces point into the current ring chunk,
+ * which is only consumed once they have all been handed out. */
+status_t
+DVDStreamDecoder::_Fill(media_header *header)
+{
+    // Navigation dropped what was demuxed so far, start over after it
+    if (fRing->CatchUp())
+        Reset();
+
+    if (fChunk != NULL && fOffset >= fChunk->size) {
+        fRing->Consume();
+        fChunk = NULL;
+    }
+
+    if (fChunk == NULL) {
+        while ((fChunk = fRing->Peek()) == NULL) {
+            status_t status = fRing->WaitForData(DVD_CHUNK_TIMEOUT);
+            if (status != B_OK && status != B_INTERRUPTED)
+                return status;
+            if (fRing->CatchUp())
+                Reset();
+        }
+
+        fOffset = 0;
+        if (header != NULL && (fChunk->flags & DVD_CHUNK_PTS) != 0)
+            header->start_time = fChunk->pts * 100 / 9;
+    }
+
+    const uint8 *data = (const uint8 *)(fChunk + 1);
+    size_t end = fChunk->size;
+    int32 mode = atomic_get(&fSkipMode);
+
+    // The end of the last chunk that might have started a picture to drop
+    bool carryQueued = fCarrySize > 0;
+    if (carryQueued) {
+        _Queue(fCarry[fCarryIndex], fCarrySize);
+        fCarryIndex ^= 1;
+        fCarrySize = 0;
+    }
+
+    // Nothing to look for, hand out the whole chunk
+    if (mode == DVD_SKIP_NONE && !fDropping && fTypeBytes == 0) {
+        _Queue(data + fOffset, end - fOffset);
+        fOffset = end;
+        fCode = 0xffffffff;
+        return B_OK;
+    }
+
+    size_t keep = fOffset;
+    bool prefixQueued = false;
+    size_t i;
+
+    for (i = fOffset; i < end && fQueued < DVD_DECODER_QUEUE - 1; i++) {
+        fCode = (fCode << 8) | data[i];
+
+        // The picture type follows the start code two bytes later
+        if (fTypeBytes > 0 && --fTypeBytes == 0 && !fDropping) {
+            int32 type = (data[i] >> 3) & 0x07;
+            if ((type == B_PICTURE && mode >= DVD_SKIP_B)
+                || (type == P_PICTURE && mode >= DVD_SKIP_P)) {
+                // Leave out everything from the picture start code on
+                if (i >= 5) {
+                    if (i - 5 > keep)
+                        _Queue(data + keep, i - 5 - keep);
+                } else if (prefixQueued || carryQueued)
+                    fQueued--;
+
+                prefixQueued = false;
+                carryQueued = false;
+
+                fDropping = true;
+                atomic_add(&fDropped, 1);
+            }
+        }
+
+        if ((fCode & 0xffffff00) != 0x00000100)
+            continue;
+
+        uint8 code = fCode & 0xff;
+        if (code == PICTURE_START_CODE)
+            fTypeBytes = 2;
+
+        prefixQueued = false;
+
+        // A dropped picture lasts until the next picture, GOP or sequence
+        if (fDropping && (code == PICTURE_START_CODE
+                || code == GROUP_START_CODE || code == SEQUENCE_START_CODE
+                || code == SEQUENCE_END_CODE)) {
+            fDropping = false;
+            if (i >= 3)
+                keep = i - 3;
+            else {
+                _Queue(kStartCode, 3 - i);
+                prefixQueued = true;
+                keep = 0;
+            }
+        }
+    }
+
+    fOffset = i;
+
+    if (!fDropping && i == end) {
+        // Hold back what could still turn out to start a dropped picture
+        size_t hold = 0;
+        if (fTypeBytes > 0)
+            hold = 6 - fTypeBytes;
+        else if ((fCode & 0xffffff) == 0x000001)
+            hold = 3;
+        else if ((fCode & 0xffff) == 0)
+            hold = 2;
+        else if ((fCode & 0xff) == 0)
+            hold = 1;
+
+        // A short chunk doesn't hold all of it, take some of the carry or
+        // start code queued right before back as well
+        size_t fresh = min_c(hold, i - keep);
+        size_t taken = 0;
+        if (hold > fresh && (carryQueued || prefixQueued)) {
+            taken = min_c(hold - fresh, fQueue[fQueued - 1].size);
+            fQueue[fQueued - 1].size -= taken;
+            memcpy(fCarry[fCarryIndex],
+                fQueue[fQueued - 1].data + fQueue[fQueued - 1].size, taken);
+            if (fQueue[fQueued - 1].size == 0)
+                fQueued--;
+        }
+
+        memcpy(fCarry[fCarryIndex] + taken, data + i - fresh, fresh);
+        fCarrySize = taken + fresh;
+        i -= fresh;
+    }
+
+    if (!fDropping && keep < i)
+        _Queue(data + keep, i - keep);
+
+    return B_OK;
+}
+
+
+void
+DVDStreamDecoder::_Queue(const uint8 *data, size_t size)
+{
+    fQueue[fQueued].data = data;
+    fQueue[fQueued].size = size;
+    fQueued++;
+}
@@ -0,0 +1,195 @@
+#ifndef DVD_DEMUXER_H
+#define DVD_DEMUXER_H
+
+#include <kernel/OS.h>
+#include <media/MediaDecoder.h>
+#include <media/MediaDefs.h>
+
+#include "dvdnav.h"
+
+/* Demuxer stream indices: the video stream, then the 8 physical audio
+ * streams, then the 32 physical subpicture streams. */
+enum {
+    DVD_STREAM_VIDEO    = 0,
+    DVD_STREAM_AUDIO    = 1,
+    DVD_STREAM_SPU      = 9,
+    DVD_STREAM_COUNT    = 41
+};
+
+#define DVD_VIDEO_RING_SIZE (2 * 1024 * 1024)
+#define DVD_AUDIO_RING_SIZE (256 * 1024)
+#define DVD_SPU_RING_SIZE   (64 * 1024)
+
+/* PTS jumps forward by up to this much (90kHz) are played as a gap, a VOBU
+ * skip to catch up is one. Other jumps are closed up. */
+#define DVD_MAX_PTS_GAP     (8 * 90000)
+
+/* Header of a chunk in a stream ring, the payload follows it. */
+struct dvd_chunk {
+    uint32      size;
+    uint32      flags;
+    int64       pts;        // 90kHz, valid with DVD_CHUNK_PTS
+};
+
+enum {
+    DVD_CHUNK_PTS   = 0x1,
+    DVD_CHUNK_SKIP  = 0x80000000    // rest of the ring is unused
+};
+
+
+/* Single producer, single consumer ring of elementary stream chunks. Both
+ * sides only touch their own counter and read the other one atomically, so
+ * neither takes a lock. A side that finds the ring full or empty can wait
+ * for the other one. */
+class DVDStreamRing {
+public:
+                        DVDStreamRing(size_t size);
+                        ~DVDStreamRing();
+
+        status_t        InitCheck() const;
+
+        // Producer side, chunks have to be far smaller than half the ring
+        bool            Write(const uint8 *data, size_t size, int64 pts,
+                            uint32 flags);
+        status_t        WaitForSpace(bigtime_t timeout);
+
+        // Consumer side, a chunk stays valid until Consume()
+        const dvd_chunk *Peek();
+        void            Consume();
+        status_t        WaitForData(bigtime_t timeout);
+
+        // Makes a waiting or the next WaitForData() return B_CANCELED,
+        // for when the producer goes away
+        void            WakeReader();
+
+        // Producer side, drops everything written so far. The consumer
+        // skips it in CatchUp().
+        void            Discard();
+        bool            CatchUp();
+
+        // Only while neither side is running
+        void            Flush();
+
+        size_t          Used();
+
+private:
+        size_t          _ChunkSize(size_t size) const;
+        void            _Wake(int32 *waiting, sem_id sem);
+        status_t        _Wait(int32 *waiting, sem_id sem, bigtime_t timeout,
+                            bool forSpace);
+
+        uint8           *fData;
+        size_t          fSize;
+        int32           fHead;
+        int32           fTail;
+
+        sem_id          fDataSem;
+        sem_id          fSpaceSem;
+        int32           fDataWaiting;
+        int32           fSpaceWaiting;
+        int32           fReaderWoken;
+
+        int32           fDiscardHead;
+        int32           fDiscards;
+        int32           fDiscardsSeen;
+};
+
+
+/* Splits the program stream into its elementary streams. Each enabled
+ * stream gets its own ring, the others are dropped. Time stamps are made
+ * continuous across cells: they start at 0 and only jump where the
+ * stream really moved on. */
+class DVDDemuxer {
+public:
+                        DVDDemuxer(dvdnav_t *nav);
+                        ~DVDDemuxer();
+
+        status_t        EnableStream(int32 stream);
+        DVDStreamRing   *StreamAt(int32 stream) const;
+
+        // Returns how many bytes were taken, a whole number of blocks.
+        // Less than 'length' means a ring was full, see WaitForSpace().
+        ssize_t         Demux(const uint8 *blocks, size_t length);
+        status_t        WaitForSpace(bigtime_t timeout);
+
+        void            Flush();
+        void            Discard();
+        bool            Drained() const;
+        void            WakeReaders();
+
+        void            ResetTime();
+        void            Resume(int64 at);
+
+static  int32           StreamFor(const dvdnav_pes_packet_t &pes);
+static  int32           AudioStreamFor(dvdnav_t *nav, int32 logical);
+static  status_t        AudioFormatFor(dvdnav_t *nav, int32 logical,
+                            media_format *format);
+
+private:
+        dvdnav_t        *fDVDNav;
+        DVDStreamRing   *fRings[DVD_STREAM_COUNT];
+        DVDStreamRing   *fBlocked;
+
+        void            _Retime(const uint8 *pci);
+
+        int64           fTimeOffset;
+        int64           fLastEnd;
+};
+
+
+enum {
+    DVD_SKIP_NONE   = 0,
+    DVD_SKIP_B      = 1,    // leave out B pictures
+    DVD_SKIP_P      = 2     // leave out B and P pictures
+};
+
+#define DVD_DECODER_QUEUE 16
+
+/* Feeds a decoder from a stream ring, optionally leaving out pictures to
+ * catch up. */
+class DVDStreamDecoder : public BMediaDecoder {
+public:
+                        DVDStreamDecoder(DVDStreamRing *ring,
+                            const media_format *format);
+
+        void            Reset();
+        void            Skip();
+
+        void            SetSkipMode(int32 mode);
+        int32           SkipMode();
+        int32           CountDropped();
+
+protected:
+virtual status_t        GetNextChunk(const void **chunk, size_t *size,
+                            media_header *header);
+
+private:
+        status_t        _Fill(media_header *header);
+        void            _Queue(const uint8 *data, size_t size);
+
+        DVDStreamRing   *fRing;
+        const dvd_chunk *fChunk;
+        size_t          fOffset;
+
+        struct {
+            const uint8 *data;
+            size_t      size;
+        }               fQueue[DVD_DECODER_QUEUE];
+        int32           fQueued;
+
+        // Held back end of the previous chunk, two of them, as the one
+        // queued last may not have been handed out yet
+        uint8           fCarry[2][8];
+        size_t          fCarrySize;
+        int32           fCarryIndex;
+
+        // Start code scanner
+        uint32          fCode;
+        int32           fTypeBytes;
+        bool            fDropping;
+
+        int32           fSkipMode;
+        int32           fDropped;
+};
+
+#endif
@@ -12,6 +12,8 @@
 #include <sys/uio.h>
 #include <unistd.h>
 
+#include <algorithm>
+
 #include <Buffer.h>
 #include <BufferGroup.h>
 #include <ParameterWeb.h>
@@ -21,9 +23,11 @@
 #include <Debug.h>
 #include <Directory.h>
 #include <Entry.h>
+#include <FindDirectory.h>
 #include <Path.h>
 
 #include "dvdnav.h"
+#include "DVDNavigation.h"
 
 #define TOUCH(x) ((void)(x))
 
@@ -39,6 +43,76 @@
 
 #define DVD_LANGUAGE "en"
 
+/* ReadAt() seeks libdvdnav instead of reading its way forward when the
+ * requested offset is further ahead of the stream than this. */
+#define DVD_MAX_SKIP (1024 * 1024)
+
+/* How long an output worker waits for a free buffer before it checks
+ * whether it should quit. */
+#define DVD_BUFFER_TIMEOUT 100000
+
+/* Buffer groups cover the downstream latency with this many buffers at
+ * least and at most. */
+#define DVD_MIN_BUFFERS 3
+#define DVD_MAX_BUFFERS 16
+
+/* Fallbacks for formats that leave the timing open */
+#define DVD_FRAME_TIME 40000
+#define DVD_AUDIO_BUFFER_TIME 20000
+#define DVD_AUDIO_BUFFER_SIZE 4096
+
+/* Catch-up levels for late notices, each one adds to the one before */
+enum {
+    DVD_LATE_NONE       = 0,
+    DVD_LATE_DROP_B     = 1,    // leave out B pictures
+    DVD_LATE_SKIP_VOBUS = 2,    // skip whole VOBUs forward
+    DVD_LATE_ONLY_I     = 3     // only decode I pictures
+};
+
+/* A VOBU covers about half a second */
+#define DVD_VOBU_TIME 500000
+
+/* Time a catch-up level gets before the next one, and time without late
+ * notices before going back a level */
+#define DVD_LATE_SETTLE 500000
+#define DVD_LATE_RECOVERY 2000000
+
+/* The DSI forward pointers reach 15 VOBUs ahead one by one */
+#define DVD_MAX_VOBU_SKIP 15
+
+/* Decoded times closer than this to where the last buffer ended are
+ * jitter, the schedule only drifts towards them by a fraction */
+#define DVD_MAX_DRIFT 20000
+#define DVD_DRIFT_DAMPING 8
+
+/* What holds up the read cursor */
+enum {
+    DVD_PAUSE_NONE      = 0,
+    DVD_PAUSE_WAIT      = 1,    // libdvdnav waits for the outputs to drain
+    DVD_PAUSE_STILL     = 2     // a still picture is showing
+};
+
+/* Stills and waits hold the stream up until the outputs have drained what
+ * was read before them, for at most this long, checking this often */
+#define DVD_DRAIN_TIMEOUT 2000000
+#define DVD_DRAIN_POLL 10000
+
+/* The demuxer looks at a held up stream at least this often */
+#define DVD_PAUSE_POLL 100000
+
+/* Still length libdvdnav gives for a still that lasts until a button is
+ * activated */
+#define DVD_STILL_ENDLESS 0xff
+
+/* Preroll() has this many VOBUs read ahead, a VOBU is about this many
+ * blocks where the index can't tell */
+#define DVD_PREROLL_VOBUS 4
+#define DVD_VOBU_BLOCKS 256
+
+/* Under the user cache directory, the IFO files of the discs seen before
+ * are kept there */
+#define DVD_IFO_CACHE "dvd"
+
 DVDDiskNode::DVDDiskNode(
         BMediaAddOn *addon, const char *name, int32 internal_id)
   : BMediaNode(name),
@@ -48,8 +122,18 @@ DVDDiskNode::DVDDiskNode(
     fInternalID(internal_id),
     fAddOn(addon),
 
-    fThread(-1),
-    fStreamSync(-1),
+    fWorkers(NULL),
+    fWorkerCount(0),
+    fLateLevel(0),
+    fLastLate(0),
+    fLastEscalation(0),
+    fLastSkip(0),
+    fVobuSkip(0),
+    fSkippedVobus(0),
+    fDemuxThread(-1),
+    fDemuxing(false),
+    fReadyFlushes(0),
+    fFlushes(0),
     fProcessingLatency(50),
 
     fRunning(false),
@@ -57,9 +141,38 @@ DVDDiskNode::DVDDiskNode(
  
     fInitStatus(B_OK),
     
-    fPosition(0)
+    fPosition(0),
+    fLength(0),
+
+    fSpan(NULL),
+    fSpanLength(0),
+    fSpanStart(0),
+    fResync(false),
+    fDemuxed(0),
+    fStopped(false),
+
+    fPause(DVD_PAUSE_NONE),
+    fStillLength(0),
+    fPauseStart(0),
+    fPauseEnd(0),
+    fPauseWake(0),
+    fPauseSem(-1),
+    fButtonCount(0),
+    fAudioStream(-1),
+    fSpuStream(-1),
+
+    fVobuIndex(NULL),
+    fVobuCount(0),
+    fIndexTitle(-1),
+    fIndexPGCLength(-1)
 {
-    fBuffer = (uint8_t *) malloc (DVD_VIDEO_LB_LEN);
+    // Direct reads of the disc need a sector aligned buffer
+    if (posix_memalign((void **)&fBuffer, DVD_VIDEO_LB_LEN, DVD_VIDEO_LB_LEN)
+            != 0)
+        fBuffer = NULL;
+    fPauseSem = create_sem(0, "dvd pause");
+    memset(fClut, 0, sizeof(fClut));
+    memset(&fHighlight, 0, sizeof(fHighlight));
         
     LoadDisk();
 
@@ -68,8 +181,15 @@ DVDDiskNode::DVDDiskNode(
         fInitStatus = B_ERROR;
         return;
     }
-    
+
+    fDemuxer = new DVDDemuxer(fDVDNav);
+
     InitOutputs();
+
+    // BMediaFile only looked around, the demuxer starts at the beginning
+    fReadLock.Lock();
+    _SeekStream(0);
+    fReadLock.Unlock();
  
     return;
 }
@@ -82,6 +202,12 @@ DVDDiskNode::LoadDisk()
     _FindDrives("/dev/disk");
     SetDrive(0);
 
+    // A disc seen before is opened without reading its IFO files
+    BPath cache;
+    if (find_directory(B_USER_CACHE_DIRECTORY, &cache, true) == B_OK
+        && cache.Append(DVD_IFO_CACHE) == B_OK)
+        DVDSetIFOCache(cache.Path());
+
     fDVDLoaded = dvdnav_open(&fDVDNav, GetDrivePath()) == DVDNAV_STATUS_OK;
 
     if (fDVDLoaded) {
@@ -95,6 +221,9 @@ DVDDiskNode::LoadDisk()
 
         dvdnav_set_PGC_positioning_flag(fDVDNav, 1);
 
+        // ReadAt() takes the blocks straight out of the read-ahead cache
+        dvdnav_set_readahead_flag(fDVDNav, 1);
+
         //dvdnav_part_play(fDVDNav, 1, 1);
         
         fPerformanceTimeBase = fPerformanceTimeBase + fProcessingLatency;
@@ -130,14 +259,17 @@ DVDDiskNode::InitOutputs()
     }
 */    
     PRINTF(1, ("InitOutputs(): BMediaFile\n"));
-    
-    fMediaFile = new BMediaFile(this, (long int) 0);
 
-    int trackCount = fMediaFile->CountTracks();
+    /* The extractor only describes the video, the demuxer reads the stream
+     * from then on. It reads through ReadAt(), which shares the demuxer's
+     * cursor, so it mustn't outlive this. */
+    BMediaFile *mediaFile = new BMediaFile(this, (long int) 0);
+
+    int trackCount = mediaFile->CountTracks();
 
     for (int32 i = 0; i < trackCount; i++) {
         PRINTF(1, ("InitOutputs(): Creating Track %i of %i\n", i, trackCount));
-        BMediaTrack* track = fMediaFile->TrackAt(i);
+        BMediaTrack* track = mediaFile->TrackAt(i);
 
         // Grab the encoded format
         media_format* encFormat = new media_format();
@@ -151,8 +283,6 @@ DVDDiskNode::InitOutputs()
         output->source.port = ControlPort();
         output->destination = media_destination::null;
 
-        int bufferSize = 0;
-
         if (encFormat->IsVideo()) {
             PRINTF(1, ("InitOutputs(): Video Track\n"));
             output->format.type = B_MEDIA_RAW_VIDEO;
@@ -161,69 +291,270 @@ DVDDiskNode::InitOutputs()
             output->format.u.raw_video.display.line_count = encFormat->Height();
             output->format.u.raw_video.display.format = encFormat->ColorSpace();
             
-            //bufferSize = encFormat->Width() * encFormat->Height();
-            bufferSize = 8147200;
-
             track->DecodedFormat(&output->format);
-            
-            // Create the buffer group for the output.
-            BBufferGroup *bufferGroup = new BBufferGroup(bufferSize, 10); // 
-            if (bufferGroup->InitCheck() < B_OK) {
-                delete bufferGroup;
-                bufferGroup = NULL;
-                return;
-            }
 
-            PRINTF(1, ("InitOutputs(): Add output %i to the list...\n", i));
-            fOutputs.push_back(output);
-            fBufferGroups.push_back(bufferGroup);
-            fTracks.push_back(track);
-            fConnected.push_back(false);
-        } else if (encFormat->IsAudio()) {
-            PRINTF(1, ("InitOutputs(): Audio Track\n"));
-            output->format.type = B_MEDIA_RAW_AUDIO;
-            output->format.u.raw_audio = media_raw_audio_format::wildcard;
-            output->format.u.raw_audio.format = encFormat->AudioFormat();
-            //output->format.u.raw_audio.frame_size = encFormat->AudioFrameSize();
-            
-            bufferSize = encFormat->u.raw_audio.buffer_size;
-
-            track->DecodedFormat(&output->format);
-            
-            // Create the buffer group for the output.
-            BBufferGroup *bufferGroup = new BBufferGroup(bufferSize, 10); // 
-            if (bufferGroup->InitCheck() < B_OK) {
-                delete bufferGroup;
-                bufferGroup = NULL;
-                return;
+            if (_AddStream(DVD_STREAM_VIDEO, encFormat, &output->format)
+                    != B_OK) {
+                delete output;
+                continue;
             }
 
             PRINTF(1, ("InitOutputs(): Add output %i to the list...\n", i));
-            fOutputs.push_back(output);
-            fBufferGroups.push_back(bufferGroup);
-            fTracks.push_back(track);
-            fConnected.push_back(false);
+            _AddOutput(output);
         } else {
+            // Audio comes from the IFO below
             PRINTF(1, ("InitOutputs(): Other Format\n"));
+            delete output;
+        }
+    }
+
+    delete mediaFile;
+
+    /* Subpicture streams get no output, nothing would drain their rings
+     * and the demuxer would stall on them, so they are left disabled.
+     *
+     * The extractor lists its audio tracks in the order it came across
+     * them in the VOB, which says nothing about the stream they carry. The
+     * audio outputs are made from the streams of the title instead. */
+    for (uint8 physical = 0; physical < 8; physical++) {
+        int8_t logical = dvdnav_get_audio_logical_stream(fDVDNav, physical);
+        if (logical < 0)
+            continue;
+
+        media_format* encFormat = new media_format();
+        if (DVDDemuxer::AudioFormatFor(fDVDNav, logical, encFormat) != B_OK) {
+            PRINTF(1, ("InitOutputs(): Audio stream %d not supported\n",
+                physical));
+            delete encFormat;
+            continue;
+        }
+
+        PRINTF(1, ("InitOutputs(): Audio stream %d\n", physical));
+        media_output *output = new media_output();
+
+        output->node = Node();
+        output->source.id = trackCount + physical;
+        output->source.port = ControlPort();
+        output->destination = media_destination::null;
+
+        output->format.type = B_MEDIA_RAW_AUDIO;
+        output->format.u.raw_audio = media_raw_audio_format::wildcard;
+
+        if (_AddStream(DVD_STREAM_AUDIO + physical, encFormat,
+                &output->format) != B_OK) {
+            delete output;
+            continue;
         }
+
+        _AddOutput(output);
+    }
+}
+
+/* The buffer group of an output is only made in Connect(), once the format
+ * is known. */
+void
+DVDDiskNode::_AddOutput(media_output *output)
+{
+    fOutputs.push_back(output);
+    fBufferGroups.push_back(NULL);
+    fOwnGroups.push_back(false);
+    fGroupLocks.push_back(new BLocker("dvd output buffers"));
+    fGroupGenerations.push_back(0);
+    fBusyGroups.push_back(NULL);
+    fRetiredGroups.push_back(NULL);
+    fBufferSizes.push_back(0);
+    fLatencies.push_back(0);
+    fReadyBuffers.push_back(NULL);
+    fReadyFrames.push_back(0);
+    fConnected.push_back(false);
+}
+
+/* Routes a demuxer stream to a new output's decoder. */
+status_t
+DVDDiskNode::_AddStream(int32 stream, const media_format *encoded,
+        media_format *decoded)
+{
+    status_t status = fDemuxer->EnableStream(stream);
+    if (status != B_OK) {
+        PRINTF(1, ("_AddStream(%ld): %s\n", stream, strerror(status)));
+        return status;
     }
+
+    DVDStreamDecoder *decoder
+        = new DVDStreamDecoder(fDemuxer->StreamAt(stream), encoded);
+    status = decoder->InitCheck();
+    if (status == B_OK)
+        status = decoder->SetOutputFormat(decoded);
+    if (status != B_OK) {
+        PRINTF(1, ("_AddStream(%ld): No decoder, %s\n", stream,
+            strerror(status)));
+        delete decoder;
+        return status;
+    }
+
+    fStreams.push_back(stream);
+    fDecoders.push_back(decoder);
+    return B_OK;
+}
+
+/* Bytes of one buffer of the negotiated format: a video frame, or the
+ * audio buffer size the consumer asked for. */
+size_t
+DVDDiskNode::_BufferSize(const media_format &format) const
+{
+    if (format.type == B_MEDIA_RAW_VIDEO) {
+        const media_video_display_info &display
+            = format.u.raw_video.display;
+        size_t bytesPerRow = display.bytes_per_row;
+        if (bytesPerRow == 0)
+            bytesPerRow = display.line_width * 4;
+
+        return bytesPerRow * display.line_count;
+    }
+
+    const media_raw_audio_format &audio = format.u.raw_audio;
+    if (audio.buffer_size > 0)
+        return audio.buffer_size;
+
+    size_t frameSize = (audio.format & 0xf) * audio.channel_count;
+    size_t size = frameSize * (size_t)(audio.frame_rate * DVD_AUDIO_BUFFER_TIME
+        / 1000000);
+
+    return size > 0 ? size : DVD_AUDIO_BUFFER_SIZE;
+}
+
+
+/* How much media time one buffer of the format covers. */
+bigtime_t
+DVDDiskNode::_BufferDuration(const media_format &format, size_t size) const
+{
+    if (format.type == B_MEDIA_RAW_VIDEO) {
+        float rate = format.u.raw_video.field_rate;
+        return rate > 0 ? (bigtime_t)(1000000 / rate) : DVD_FRAME_TIME;
+    }
+
+    const media_raw_audio_format &audio = format.u.raw_audio;
+    double bytesPerSecond = (audio.format & 0xf) * audio.channel_count
+        * audio.frame_rate;
+    if (bytesPerSecond <= 0)
+        return DVD_AUDIO_BUFFER_TIME;
+
+    return (bigtime_t)(size * 1000000.0 / bytesPerSecond);
+}
+
+
+/* Makes a group for a connected output, just big enough to cover the
+ * latency downstream with a couple of buffers to spare. */
+status_t
+DVDDiskNode::_CreateBufferGroup(int32 output)
+{
+    const media_format &format = fOutputs[output]->format;
+    size_t size = _BufferSize(format);
+
+    bigtime_t latency = 0;
+    media_node_id timeSource;
+    if (FindLatencyFor(fOutputs[output]->destination, &latency, &timeSource)
+            != B_OK)
+        latency = 0;
+    fLatencies[output] = latency;
+
+    bigtime_t duration = max_c(_BufferDuration(format, size), 1);
+    int32 count = (latency + fProcessingLatency) / duration + 2;
+    count = max_c(DVD_MIN_BUFFERS, min_c(count, DVD_MAX_BUFFERS));
+
+    PRINTF(1, ("_CreateBufferGroup(%ld): %ld buffers of %lu bytes\n",
+        output, count, (unsigned long)size));
+
+    BBufferGroup *group = new BBufferGroup(size, count);
+    status_t status = group->InitCheck();
+    if (status != B_OK) {
+        delete group;
+        return status;
+    }
+
+    _SetBufferGroup(output, group, true);
+    return B_OK;
+}
+
+
+/* Replaces the group of an output, deleting the old one if it was ours.
+ * The worker may be decoding into a buffer of the old group, it drops it
+ * once it sees the generation change. Until then an old group of ours is
+ * only retired, the worker deletes it in _ReleaseGroup(). */
+void
+DVDDiskNode::_SetBufferGroup(int32 output, BBufferGroup *group, bool own)
+{
+    BAutolock _(fGroupLocks[output]);
+
+    fGroupGenerations[output]++;
+
+    // A buffer decoded ahead belongs to the old group
+    if (fReadyBuffers[output] != NULL) {
+        fReadyBuffers[output]->Recycle();
+        fReadyBuffers[output] = NULL;
+    }
+
+    if (fOwnGroups[output]) {
+        if (fBufferGroups[output] == fBusyGroups[output])
+            fRetiredGroups[output] = fBufferGroups[output];
+        else
+            delete fBufferGroups[output];
+    }
+
+    fBufferGroups[output] = group;
+    fOwnGroups[output] = group != NULL && own;
+    fBufferSizes[output] = group != NULL ? _BufferSize(fOutputs[output]->format)
+        : 0;
+}
+
+/* Gives back a buffer the worker took but won't send. */
+void
+DVDDiskNode::_ReturnBuffer(int32 output, BBuffer *buffer)
+{
+    BAutolock _(fGroupLocks[output]);
+
+    buffer->Recycle();
+    _ReleaseGroup(output);
+}
+
+/* The worker holds no buffer anymore, a group retired while it did can go.
+ * Called with the group lock held. */
+void
+DVDDiskNode::_ReleaseGroup(int32 output)
+{
+    fBusyGroups[output] = NULL;
+
+    delete fRetiredGroups[output];
+    fRetiredGroups[output] = NULL;
 }
 
 DVDDiskNode::~DVDDiskNode()
 {
     if (fInitStatus == B_OK) {
+        // The workers use the buffer groups
+        if (fRunning)
+            HandleStop();
+        _StopDemuxer();
+
         for (uint32 i = 0; i < fOutputs.size(); i++) {
             Disconnect(fOutputs[i]->source, fOutputs[i]->destination);
 
-            fLock.Lock();
-            delete fBufferGroups[i];
-            fBufferGroups[i] = NULL;
-            fLock.Unlock();
+            _SetBufferGroup(i, NULL, false);
+            delete fGroupLocks[i];
         }
 
-        if (fRunning)
-            HandleStop();
+        fReadLock.Lock();
+        _ReleaseSpan();
+        _FreeIndex();
+        fReadLock.Unlock();
+
+        for (uint32 i = 0; i < fDecoders.size(); i++)
+            delete fDecoders[i];
+        delete fDemuxer;
     }
+
+    delete_sem(fPauseSem);
+    free(fBuffer);
 }
 
 /* BDataIO */
@@ -231,7 +562,7 @@ DVDDiskNode::~DVDDiskNode()
 ssize_t
 DVDDiskNode::Read(void *buffer, size_t size)
 {
-    printf("DVD::Read(%Zu) Called\n", size);
+    PRINTF(2, ("Read(%lu)\n", (unsigned long)size));
     
 	off_t curPos = Position();
 	ssize_t result = ReadAt(curPos, buffer, size);
@@ -245,32 +576,395 @@ DVDDiskNode::Read(void *buffer, size_t size)
 ssize_t
 DVDDiskNode::ReadAt(off_t pos, void *buffer, size_t size)
 {
-    printf("DVD::ReadAt(%i, %lu)\n", (int)pos, (unsigned long)size);
+    PRINTF(2, ("ReadAt(%Ld, %lu)\n", pos, (unsigned long)size));
 
-    int blockCount = ceil(size / DVD_VIDEO_LB_LEN);
+    if (pos < 0)
+        return B_BAD_VALUE;
 
-    uint8_t *buf = (uint8_t *) buffer;
-    buf = new uint8_t[blockCount * DVD_VIDEO_LB_LEN];
+    BAutolock _(fReadLock);
 
-    for (int i = 0; i < blockCount; i++) {
-        fResult = dvdnav_get_next_block(fDVDNav, buf + i * DVD_VIDEO_LB_LEN, &fEvent, &fLen);
+    // Offsets behind the cursor, or far ahead of it, need libdvdnav to seek.
+    if (pos < fSpanStart
+        || pos >= fSpanStart + (off_t)fSpanLength + DVD_MAX_SKIP) {
+        if (_SeekStream(pos) != B_OK)
+            return B_ERROR;
+    }
 
-        if (fResult == DVDNAV_STATUS_ERR) {
-            printf("DVD: Error getting next block: %s\n", dvdnav_err_to_string(fDVDNav));
+    uint8 *out = (uint8 *)buffer;
+    size_t done = 0;
+    status_t status = B_OK;
+
+    while (done < size) {
+        off_t current = pos + done;
+
+        if (current >= fSpanStart + (off_t)fSpanLength) {
+            status = _NextSpan();
+            if (status != B_OK)
+                break;
+            continue;
+        }
+
+        // A seek landed behind the wanted offset, nothing sensible to return
+        if (current < fSpanStart) {
+            status = B_ERROR;
+            break;
+        }
+
+        size_t offset = current - fSpanStart;
+        size_t count = min_c(size - done, fSpanLength - offset);
+        memcpy(out + done, fSpan + offset, count);
+        done += count;
+    }
+
+    if (done > 0)
+        return done;
+
+    return status == B_LAST_BUFFER_ERROR ? 0 : status;
+}
+
+
+/* Gives the blocks the read cursor holds back to libdvdnav and moves the
+ * cursor past them. */
+void
+DVDDiskNode::_ReleaseSpan()
+{
+    if (fSpan != NULL && fSpan != fBuffer)
+        dvdnav_free_cache_block(fDVDNav, fSpan);
+
+    fSpanStart += fSpanLength;
+    fSpan = NULL;
+    fSpanLength = 0;
+    fDemuxed = 0;
+}
+
+
+/* Moves the read cursor to the next run of blocks of the program stream,
+ * NAV packs included, and dispatches the libdvdnav events on the way.
+ * With 'hold', stills and waits play out: B_WOULD_BLOCK is returned until
+ * they are over, see _EndPause(). Otherwise they are skipped right away.
+ * Returns B_LAST_BUFFER_ERROR once playback stops. */
+status_t
+DVDDiskNode::_NextSpan(bool hold)
+{
+    _ReleaseSpan();
+
+    while (true) {
+        uint8_t *block = fBuffer;
+        int32_t event, len;
+
+        if (fPause != DVD_PAUSE_NONE) {
+            status_t status = _EndPause(hold);
+            if (status != B_OK)
+                return status;
+        }
+
+        if (dvdnav_get_next_cache_span(fDVDNav, &block, &event, &len)
+                == DVDNAV_STATUS_ERR) {
+            printf("DVD: Error getting next block: %s\n",
+                dvdnav_err_to_string(fDVDNav));
             return B_ERROR;
         }
 
-        while (fEvent != DVDNAV_BLOCK_OK) {
-            fResult = dvdnav_get_next_block(fDVDNav, buf + i * DVD_VIDEO_LB_LEN, &fEvent, &fLen);
+        switch (event) {
+            case DVDNAV_NAV_PACKET:
+                if (_SkipVobus()) {
+                    // This VOBU is left out
+                    if (block != fBuffer)
+                        dvdnav_free_cache_block(fDVDNav, block);
+                    break;
+                }
+
+                if (fResync) {
+                    // After a seek, the first NAV packet tells where we are
+                    uint32_t sector, length;
+                    if (dvdnav_get_position(fDVDNav, &sector, &length)
+                            == DVDNAV_STATUS_OK)
+                        fSpanStart = (off_t)sector * DVD_VIDEO_LB_LEN;
+                    fResync = false;
+                }
+
+                _HandleNavPacket();
+                // fall through
+            case DVDNAV_BLOCK_OK:
+                fSpan = block;
+                fSpanLength = len;
+                return B_OK;
+
+            case DVDNAV_STOP:
+                return B_LAST_BUFFER_ERROR;
+
+            default:
+                _HandleEvent(event, block);
+                break;
+        }
+    }
+}
+
+
+/* Takes what the node keeps track of from the PCI of a new VOBU. */
+void
+DVDDiskNode::_HandleNavPacket()
+{
+    pci_t *pci = dvdnav_get_current_nav_pci(fDVDNav);
+    if (pci == NULL)
+        return;
+
+    BAutolock _(fLock);
+    fButtonCount = pci->hli.hl_gi.hli_ss != 0 ? pci->hli.hl_gi.btn_ns : 0;
+}
+
+
+/* Dispatches the libdvdnav events that come between the blocks into node
+ * state. Stills and waits only start here, _EndPause() ends them. */
+void
+DVDDiskNode::_HandleEvent(int32 event, const uint8 *data)
+{
+    switch (event) {
+        case DVDNAV_CELL_CHANGE:
+        {
+            // A new program chain brings its own offset space
+            const dvdnav_cell_change_event_t *cell
+                = (const dvdnav_cell_change_event_t *)data;
+            int32_t title = 0, part = 0;
+            dvdnav_current_title_info(fDVDNav, &title, &part);
+            if (title != fIndexTitle
+                || cell->pgc_length != fIndexPGCLength) {
+                _FreeIndex();
+                fIndexTitle = title;
+                fIndexPGCLength = cell->pgc_length;
+                fResync = true;
+            }
+            break;
+        }
+
+        case DVDNAV_VTS_CHANGE:
+            _FreeIndex();
+            fIndexTitle = -1;
+            fIndexPGCLength = -1;
+            fResync = true;
+            break;
+
+        case DVDNAV_AUDIO_STREAM_CHANGE:
+        {
+            const dvdnav_audio_stream_change_event_t *change
+                = (const dvdnav_audio_stream_change_event_t *)data;
+            BAutolock _(fLock);
+            fAudioStream = change->physical;
+            PRINTF(1, ("Audio stream %d\n", change->physical));
+            break;
+        }
 
-            if (fResult == DVDNAV_STATUS_ERR) {
-                printf("DVD: Error getting next block: %s\n", dvdnav_err_to_string(fDVDNav));
-                return B_ERROR;
+        case DVDNAV_SPU_STREAM_CHANGE:
+        {
+            const dvdnav_spu_stream_change_event_t *change
+                = (const dvdnav_spu_stream_change_event_t *)data;
+            BAutolock _(fLock);
+            fSpuStream = change->physical_wide;
+            PRINTF(1, ("Subpicture stream %d\n", change->physical_wide));
+            break;
+        }
+
+        case DVDNAV_SPU_CLUT_CHANGE:
+        {
+            BAutolock _(fLock);
+            memcpy(fClut, data, sizeof(fClut));
+            break;
+        }
+
+        case DVDNAV_HIGHLIGHT:
+        {
+            // Only the button number is filled in, the PCI has the rest
+            const dvdnav_highlight_event_t *highlight
+                = (const dvdnav_highlight_event_t *)data;
+            dvdnav_highlight_area_t area;
+            pci_t *pci = dvdnav_get_current_nav_pci(fDVDNav);
+
+            BAutolock _(fLock);
+            if (highlight->buttonN != 0 && pci != NULL
+                && dvdnav_get_highlight_area(pci, highlight->buttonN, 0,
+                    &area) == DVDNAV_STATUS_OK) {
+                fHighlight = area;
+                fHighlight.buttonN = highlight->buttonN;
             }
+            else
+                memset(&fHighlight, 0, sizeof(fHighlight));
+            break;
         }
+
+        case DVDNAV_STILL_FRAME:
+            fPause = DVD_PAUSE_STILL;
+            fStillLength = ((const dvdnav_still_event_t *)data)->length;
+            fPauseStart = system_time();
+            fPauseEnd = 0;
+            break;
+
+        case DVDNAV_WAIT:
+            fPause = DVD_PAUSE_WAIT;
+            fPauseStart = system_time();
+            fPauseEnd = 0;
+            break;
+
+        // Navigation flushes by itself, a jump of the program itself plays
+        // out what was read before it
+        case DVDNAV_HOP_CHANNEL:
+        case DVDNAV_NOP:
+        default:
+            break;
     }
-    
-    return blockCount * DVD_VIDEO_LB_LEN;
+}
+
+
+/* Ends a still or wait once it has played out: after the outputs drained
+ * what was read before it and, for a still, once its length has passed.
+ * Until then B_WOULD_BLOCK is returned and fPauseWake says when to look
+ * again. An endless still only ends through navigation. */
+status_t
+DVDDiskNode::_EndPause(bool hold)
+{
+    bigtime_t now = system_time();
+
+    if (hold && fPauseEnd == 0) {
+        if (!fDemuxer->Drained() && now - fPauseStart < DVD_DRAIN_TIMEOUT) {
+            fPauseWake = now + DVD_DRAIN_POLL;
+            return B_WOULD_BLOCK;
+        }
+
+        // The last picture before the still is showing now
+        if (fPause != DVD_PAUSE_STILL)
+            fPauseEnd = now;
+        else if (fStillLength == DVD_STILL_ENDLESS)
+            fPauseEnd = B_INFINITE_TIMEOUT;
+        else
+            fPauseEnd = now + fStillLength * 1000000LL;
+    }
+
+    if (hold && now < fPauseEnd) {
+        fPauseWake = fPauseEnd;
+        return B_WOULD_BLOCK;
+    }
+
+    if (fPause == DVD_PAUSE_STILL)
+        dvdnav_still_skip(fDVDNav);
+    else
+        dvdnav_wait_skip(fDVDNav);
+
+    fPause = DVD_PAUSE_NONE;
+
+    // What comes next is due now, not where the stream left off
+    if (hold && fRunning && TimeSource() != NULL) {
+        bigtime_t due = TimeSource()->Now() - fPerformanceTimeBase
+            + _OutputLatency();
+        fDemuxer->Resume(due * 9 / 100);
+    }
+
+    return B_OK;
+}
+
+/* Points libdvdnav at the VOBU holding stream offset 'pos'. With the index
+ * the VOBU start is known up front, otherwise the cursor is placed for real
+ * once the NAV packet of that VOBU comes in. */
+status_t
+DVDDiskNode::_SeekStream(off_t pos)
+{
+    uint32_t sector = pos / DVD_VIDEO_LB_LEN;
+    bool exact = false;
+
+    if (fVobuIndex == NULL)
+        _BuildIndex();
+
+    if (fVobuIndex != NULL && sector < (uint32_t)(fLength / DVD_VIDEO_LB_LEN)) {
+        // Last VOBU starting at or before the wanted sector
+        uint32_t *vobu = std::upper_bound(fVobuIndex,
+            fVobuIndex + fVobuCount, sector);
+        if (vobu != fVobuIndex) {
+            sector = *(vobu - 1);
+            exact = true;
+        }
+    }
+
+    if (dvdnav_sector_search(fDVDNav, sector, SEEK_SET)
+            != DVDNAV_STATUS_OK) {
+        printf("DVD: Error seeking: %s\n", dvdnav_err_to_string(fDVDNav));
+        return B_ERROR;
+    }
+
+    _ReleaseSpan();
+    if (exact)
+        fSpanStart = (off_t)sector * DVD_VIDEO_LB_LEN;
+    else
+        fSpanStart = pos - pos % DVD_VIDEO_LB_LEN;
+    fResync = !exact;
+
+    return B_OK;
+}
+
+
+/* Carries out a VOBU skip asked for by _CatchUp(), at the NAV packet that
+ * starts a VOBU, through the DSI forward pointers. Returns true if
+ * libdvdnav was moved on. */
+bool
+DVDDiskNode::_SkipVobus()
+{
+    int32 count = atomic_set(&fVobuSkip, 0);
+    if (count <= 0)
+        return false;
+
+    dsi_t *dsi = dvdnav_get_current_nav_dsi(fDVDNav);
+    if (dsi == NULL)
+        return false;
+
+    // fwda[18] points at the next VOBU, fwda[19 - n] n VOBUs ahead
+    count = min_c(count, DVD_MAX_VOBU_SKIP);
+    uint32 offset = SRI_END_OF_CELL;
+    for (; count > 0; count--) {
+        offset = dsi->vobu_sri.fwda[19 - count] & SRI_END_OF_CELL;
+        if (offset != SRI_END_OF_CELL && offset != 0)
+            break;
+    }
+
+    // Nothing ahead in this cell, the cell change catches up instead
+    if (count == 0)
+        return false;
+
+    if (dvdnav_sector_search(fDVDNav, offset, SEEK_CUR) != DVDNAV_STATUS_OK)
+        return false;
+
+    atomic_add(&fSkippedVobus, count);
+    fResync = true;
+    return true;
+}
+
+
+/* Asks libdvdnav for the VOBU starts of the current program chain, so
+ * _SeekStream() can go straight to the VOBU holding an offset. */
+status_t
+DVDDiskNode::_BuildIndex()
+{
+    _FreeIndex();
+
+    uint32_t length = 0;
+    fVobuCount = dvdnav_describe_pgc_vobus(fDVDNav, &fVobuIndex, &length);
+    if (fVobuCount == 0) {
+        PRINTF(1, ("_BuildIndex() failed: %s\n",
+            dvdnav_err_to_string(fDVDNav)));
+        fVobuIndex = NULL;
+        return B_ERROR;
+    }
+
+    fLength = (off_t)length * DVD_VIDEO_LB_LEN;
+    PRINTF(2, ("_BuildIndex(): %lu VOBUs, %Ld bytes\n",
+        (unsigned long)fVobuCount, fLength));
+
+    return B_OK;
+}
+
+
+void
+DVDDiskNode::_FreeIndex()
+{
+    free(fVobuIndex);
+    fVobuIndex = NULL;
+    fVobuCount = 0;
 }
 
 
@@ -285,18 +979,21 @@ DVDDiskNode::WriteAt(off_t pos, const void *buffer, size_t size)
 off_t
 DVDDiskNode::Seek(off_t position, uint32 seekMode)
 {
+    // Only the position moves, ReadAt() repositions libdvdnav when needed
 	switch (seekMode) {
 		case SEEK_SET:
 			fPosition = position;
-            dvdnav_sector_search(fDVDNav, fPosition, SEEK_SET);
 			break;
 		case SEEK_END:
+		{
+			BAutolock _(fReadLock);
+			if (fVobuIndex == NULL)
+				_BuildIndex();
 			fPosition = fLength + position;
-            dvdnav_sector_search(fDVDNav, fPosition, SEEK_END);
 			break;
+		}
 		case SEEK_CUR:
 			fPosition += position;
-            dvdnav_sector_search(fDVDNav, fPosition, SEEK_CUR);
 			break;
 		default:
 			break;
@@ -332,14 +1029,91 @@ void
 DVDDiskNode::Preroll()
 {
     /* This hook may be called before the node is started to give the hardware
-     * a chance to start. */
+     * a chance to start. Reading the first VOBU spins the disc up and loads
+     * the IFOs, the VOBUs after it go to the read-ahead cache and the video
+     * outputs get their first picture decoded, so Start() only sends it. */
+
+    PRINTF(1, ("Preroll()\n"));
+
+    if (!fDVDLoaded || fRunning)
+        return;
+
+    fReadLock.Lock();
+
+    if (fSpanLength == 0 && _NextSpan(true) != B_OK) {
+        fReadLock.Unlock();
+        return;
+    }
+
+    uint32 blocks = DVD_PREROLL_VOBUS * DVD_VOBU_BLOCKS;
+    if (fVobuIndex != NULL) {
+        uint32_t sector = fSpanStart / DVD_VIDEO_LB_LEN;
+        uint32_t *first = std::upper_bound(fVobuIndex,
+            fVobuIndex + fVobuCount, sector);
+        if (first != fVobuIndex) {
+            uint32_t *last = first + min_c(DVD_PREROLL_VOBUS - 1,
+                fVobuIndex + fVobuCount - first);
+            uint32_t end = last < fVobuIndex + fVobuCount ? *last
+                : (uint32_t)(fLength / DVD_VIDEO_LB_LEN);
+            blocks = end - *(first - 1);
+        }
+    }
+
+    if (dvdnav_pre_cache(fDVDNav, blocks) != DVDNAV_STATUS_OK)
+        PRINTF(1, ("Preroll: %s\n", dvdnav_err_to_string(fDVDNav)));
+
+    fReadLock.Unlock();
+
+    if (_StartDemuxer() != B_OK)
+        return;
+
+    fReadyFlushes = atomic_get(&fFlushes);
+    for (uint32 i = 0; i < fOutputs.size(); i++) {
+        if (fConnected[i] && fOutputs[i]->format.type == B_MEDIA_RAW_VIDEO)
+            _PrepareBuffer(i);
+    }
+}
+
+/* Decodes the first buffer of an output ahead of time, its worker sends it
+ * before decoding anything else. The group is only replaced from this
+ * thread, so it stays while the buffer is decoded. A running worker
+ * decodes the stream itself. */
+void
+DVDDiskNode::_PrepareBuffer(int32 output)
+{
+    if (fRunning)
+        return;
+
+    fGroupLocks[output]->Lock();
+
+    BBuffer *buffer = NULL;
+    if (fReadyBuffers[output] == NULL && fBufferGroups[output] != NULL) {
+        buffer = fBufferGroups[output]->RequestBuffer(
+            fBufferSizes[output], DVD_BUFFER_TIMEOUT);
+    }
+
+    fGroupLocks[output]->Unlock();
+
+    if (!buffer)
+        return;
+
+    int64 frameCount;
+    if (fDecoders[output]->Decode(buffer->Data(), &frameCount,
+            buffer->Header()) != B_OK) {
+        buffer->Recycle();
+        return;
+    }
+
+    BAutolock _(fGroupLocks[output]);
+    fReadyBuffers[output] = buffer;
+    fReadyFrames[output] = frameCount;
 }
 
 void
 DVDDiskNode::SetTimeSource(BTimeSource *time_source)
 {
-    /* Tell frame generation thread to recalculate delay value */
-    release_sem(fStreamSync);
+    /* Tell frame generation threads to recalculate delay value */
+    _WakeWorkers();
 }
 
 /* BMediaEventLooper */
@@ -525,9 +1299,18 @@ status_t
 DVDDiskNode::SetBufferGroup(const media_source &for_source,
         BBufferGroup *group)
 {
-    TOUCH(for_source); TOUCH(group);
+    for (uint32 i = 0; i < fOutputs.size(); i++) {
+        if (fOutputs[i]->source == for_source) {
+            // NULL asks for our own group again
+            if (group == NULL)
+                return _CreateBufferGroup(i);
 
-    return B_ERROR;
+            _SetBufferGroup(i, group, false);
+            return B_OK;
+        }
+    }
+
+    return B_MEDIA_BAD_SOURCE;
 }
 
 status_t
@@ -603,12 +1386,19 @@ DVDDiskNode::Connect(status_t error, const media_source &source,
             }
 
             fOutputs[i]->destination = destination;
+            fOutputs[i]->format = format;
             strcpy(io_name, fOutputs[i]->name);
 
-            /* Tell frame generation thread to recalculate delay value */
-            release_sem(fStreamSync);
-            
+            if (_CreateBufferGroup(i) != B_OK) {
+                PRINTF(1, ("Connect: No buffers\n"));
+                fOutputs[i]->destination = media_destination::null;
+                return;
+            }
+
             fConnected[i] = true;
+
+            /* Tell frame generation thread to recalculate delay value */
+            _WakeWorkers(i);
         }
     }
 }
@@ -633,6 +1423,9 @@ DVDDiskNode::Disconnect(const media_source &source,
 
             fOutputs[i]->destination = media_destination::null;
             fConnected[i] = false;
+
+            _SetBufferGroup(i, NULL, false);
+            return;
         }
     }
 
@@ -644,7 +1437,31 @@ void
 DVDDiskNode::LateNoticeReceived(const media_source &source,
         bigtime_t how_much, bigtime_t performance_time)
 {
-    TOUCH(source); TOUCH(how_much); TOUCH(performance_time);
+    TOUCH(performance_time);
+
+    for (uint32 i = 0; i < fOutputs.size(); i++) {
+        if (fOutputs[i]->source != source)
+            continue;
+
+        PRINTF(1, ("LateNoticeReceived(%ld): %Ld late\n", i, how_much));
+
+        switch (RunMode()) {
+            case B_INCREASE_LATENCY:
+                // Give ourselves more time instead of leaving anything out
+                fProcessingLatency += how_much;
+                SetEventLatency(fProcessingLatency);
+                break;
+
+            case B_RECORDING:
+            case B_OFFLINE:
+                break;
+
+            default:
+                _CatchUp(how_much);
+                break;
+        }
+        return;
+    }
 }
 
 void
@@ -677,7 +1494,16 @@ DVDDiskNode::LatencyChanged(const media_source &source,
         const media_destination &destination, bigtime_t new_latency,
         uint32 flags)
 {
-    TOUCH(source); TOUCH(destination); TOUCH(new_latency); TOUCH(flags);
+    TOUCH(flags);
+
+    for (uint32 i = 0; i < fOutputs.size(); i++) {
+        if (fOutputs[i]->source == source
+            && fOutputs[i]->destination == destination) {
+            fLatencies[i] = new_latency;
+            _WakeWorkers(i);
+            break;
+        }
+    }
 }
 
 
@@ -686,14 +1512,199 @@ DVDDiskNode::LatencyChanged(const media_source &source,
 status_t
 DVDDiskNode::HandleMessage(int32 message, const void *data, size_t size)
 {
+    switch (message) {
+        case DVD_NAV_TITLE_PLAY:
+        case DVD_NAV_PART_PLAY:
+        case DVD_NAV_TIME_SEARCH:
+        case DVD_NAV_MENU_CALL:
+        case DVD_NAV_BUTTON_SELECT:
+        case DVD_NAV_ANGLE_CHANGE:
+            if (data == NULL || size < sizeof(dvd_nav_command))
+                return B_BAD_VALUE;
+            // fall through
+        case DVD_NAV_PREV_PART:
+        case DVD_NAV_NEXT_PART:
+        case DVD_NAV_GO_UP:
+        case DVD_NAV_BUTTON_ACTIVATE:
+        case DVD_NAV_BUTTON_UP:
+        case DVD_NAV_BUTTON_DOWN:
+        case DVD_NAV_BUTTON_LEFT:
+        case DVD_NAV_BUTTON_RIGHT:
+            return _Navigate(message, (const dvd_nav_command *)data);
+
+        case DVD_NAV_GET_STATE:
+            if (data == NULL || size < sizeof(dvd_nav_state_request))
+                return B_BAD_VALUE;
+            return _ReplyState(
+                ((const dvd_nav_state_request *)data)->reply_port);
+    }
+
     return B_ERROR;
 }
 
+/* Sends the presentation state libdvdnav left in the node, see
+ * _HandleEvent(). */
+status_t
+DVDDiskNode::_ReplyState(port_id port)
+{
+    dvd_nav_state state;
+    memset(&state, 0, sizeof(state));
+
+    {
+        BAutolock _(fLock);
+        state.audio_stream = fAudioStream;
+        state.spu_stream = fSpuStream;
+        memcpy(state.clut, fClut, sizeof(state.clut));
+        state.button_count = fButtonCount;
+        state.button = fHighlight.buttonN;
+        state.button_palette = fHighlight.palette;
+        state.button_left = fHighlight.sx;
+        state.button_top = fHighlight.sy;
+        state.button_right = fHighlight.ex;
+        state.button_bottom = fHighlight.ey;
+    }
+
+    // The stream changes, the output that carries it stays
+    state.audio_output = -1;
+    for (uint32 i = 0; i < fStreams.size(); i++) {
+        if (state.audio_stream >= 0
+            && fStreams[i] == DVD_STREAM_AUDIO + state.audio_stream)
+            state.audio_output = fOutputs[i]->source.id;
+    }
+
+    return write_port_etc(port, DVD_NAV_STATE, &state, sizeof(state),
+        B_RELATIVE_TIMEOUT, 0);
+}
+
+/* Carries out a navigation command between two spans of the read cursor,
+ * libdvdnav then goes on from the start of a VOBU at the new position.
+ * Commands that leave the current position drop what was read for it. */
+status_t
+DVDDiskNode::_Navigate(int32 message, const dvd_nav_command *command)
+{
+    PRINTF(1, ("_Navigate(%.4s)\n", (const char *)&message));
+
+    if (!fDVDLoaded)
+        return B_NO_INIT;
+
+    BAutolock _(fReadLock);
+
+    pci_t *pci = dvdnav_get_current_nav_pci(fDVDNav);
+    dvdnav_status_t result;
+    bool jump = true;
+
+    switch (message) {
+        case DVD_NAV_TITLE_PLAY:
+            result = dvdnav_title_play(fDVDNav, command->title);
+            break;
+        case DVD_NAV_PART_PLAY:
+            result = dvdnav_part_play(fDVDNav, command->title,
+                command->value);
+            break;
+        case DVD_NAV_TIME_SEARCH:
+            result = dvdnav_absolute_time_search(fDVDNav, command->time, 0);
+            break;
+        case DVD_NAV_PREV_PART:
+            result = dvdnav_prev_pg_search(fDVDNav);
+            break;
+        case DVD_NAV_NEXT_PART:
+            result = dvdnav_next_pg_search(fDVDNav);
+            break;
+        case DVD_NAV_MENU_CALL:
+            result = dvdnav_menu_call(fDVDNav, (DVDMenuID_t)command->value);
+            break;
+        case DVD_NAV_GO_UP:
+            result = dvdnav_go_up(fDVDNav);
+            break;
+        case DVD_NAV_BUTTON_ACTIVATE:
+            result = dvdnav_button_activate(fDVDNav, pci);
+            break;
+
+        // These only move the highlight or take effect at the next
+        // interleaved unit, playback goes on
+        case DVD_NAV_BUTTON_SELECT:
+            result = dvdnav_button_select(fDVDNav, pci, command->value);
+            jump = false;
+            break;
+        case DVD_NAV_BUTTON_UP:
+            result = dvdnav_upper_button_select(fDVDNav, pci);
+            jump = false;
+            break;
+        case DVD_NAV_BUTTON_DOWN:
+            result = dvdnav_lower_button_select(fDVDNav, pci);
+            jump = false;
+            break;
+        case DVD_NAV_BUTTON_LEFT:
+            result = dvdnav_left_button_select(fDVDNav, pci);
+            jump = false;
+            break;
+        case DVD_NAV_BUTTON_RIGHT:
+            result = dvdnav_right_button_select(fDVDNav, pci);
+            jump = false;
+            break;
+        case DVD_NAV_ANGLE_CHANGE:
+            result = dvdnav_angle_change(fDVDNav, command->value);
+            jump = false;
+            break;
+
+        default:
+            return B_ERROR;
+    }
+
+    if (result != DVDNAV_STATUS_OK) {
+        PRINTF(1, ("_Navigate: %s\n", dvdnav_err_to_string(fDVDNav)));
+        return B_ERROR;
+    }
+
+    if (jump)
+        _FlushStream();
+
+    return B_OK;
+}
+
+/* Drops everything between the read cursor and the outputs: the span, what
+ * the rings hold and the buffers the workers have decoded but not sent.
+ * The stream time starts over with the next VOBU, which is due right away.
+ * Must be called with fReadLock held. */
+void
+DVDDiskNode::_FlushStream()
+{
+    _ReleaseSpan();
+    fResync = true;
+
+    // A still or wait of the old position is over, libdvdnav has moved on,
+    // and so has a demuxer that ran into the end
+    fPause = DVD_PAUSE_NONE;
+    fStopped = false;
+    release_sem(fPauseSem);
+
+    fDemuxer->Discard();
+    atomic_add(&fFlushes, 1);
+
+    if (fRunning && TimeSource() != NULL)
+        fPerformanceTimeBase = TimeSource()->Now() + _OutputLatency();
+
+    _WakeWorkers();
+}
+
+/* How far ahead of their performance time buffers have to leave, for the
+ * slowest output. */
+bigtime_t
+DVDDiskNode::_OutputLatency()
+{
+    bigtime_t latency = 0;
+    for (uint32 i = 0; i < fLatencies.size(); i++)
+        latency = max_c(latency, fLatencies[i]);
+
+    return latency + fProcessingLatency;
+}
+
 
 void
 DVDDiskNode::HandleStart(bigtime_t performance_time)
 {
-    /* Start producing frames, even if the output hasn't been connected yet. */
+    /* Start producing frames, even if the outputs haven't been connected
+     * yet. */
 
     PRINTF(1, ("HandleStart(%Ld)\n", performance_time));
 
@@ -704,23 +1715,56 @@ DVDDiskNode::HandleStart(bigtime_t performance_time)
 
     fPerformanceTimeBase = performance_time;
 
-    fStreamSync = create_sem(0, "stream synchronization");
-    if (fStreamSync < B_OK)
-        goto err1;
+    // Already running if the node was prerolled
+    if (_StartDemuxer() != B_OK)
+        return;
 
-    fThread = spawn_thread(_stream_generator_, "stream generator",
-            B_NORMAL_PRIORITY, this);
-    if (fThread < B_OK)
-        goto err2;
+    fWorkerCount = 0;
+    fWorkers = new output_worker[fOutputs.size()];
+
+    for (uint32 i = 0; i < fOutputs.size(); i++) {
+        output_worker &worker = fWorkers[i];
+        char name[B_OS_NAME_LENGTH];
+
+        worker.node = this;
+        worker.output = i;
+
+        snprintf(name, sizeof(name), "dvd output %ld sync", (long)i);
+        worker.sync = create_sem(0, name);
+        if (worker.sync < B_OK)
+            goto err2;
+
+        // Audio runs out sooner than a video frame goes stale
+        int32 priority = fOutputs[i]->format.type == B_MEDIA_RAW_AUDIO
+            ? B_URGENT_DISPLAY_PRIORITY : B_DISPLAY_PRIORITY;
+
+        snprintf(name, sizeof(name), "dvd output %ld", (long)i);
+        worker.thread = spawn_thread(_stream_generator_, name, priority,
+            &worker);
+        if (worker.thread < B_OK) {
+            delete_sem(worker.sync);
+            goto err2;
+        }
+
+        fWorkerCount++;
+    }
 
-    resume_thread(fThread);
+    for (int32 i = 0; i < fWorkerCount; i++)
+        resume_thread(fWorkers[i].thread);
 
     fRunning = true;
     return;
 
 err2:
-    delete_sem(fStreamSync);
-err1:
+    for (int32 i = 0; i < fWorkerCount; i++) {
+        delete_sem(fWorkers[i].sync);
+        kill_thread(fWorkers[i].thread);
+    }
+    delete[] fWorkers;
+    fWorkers = NULL;
+    fWorkerCount = 0;
+
+    _StopDemuxer();
     return;
 }
 
@@ -734,8 +1778,21 @@ DVDDiskNode::HandleStop(void)
         return;
     }
 
-    delete_sem(fStreamSync);
-    wait_for_thread(fThread, &fThread);
+    // Workers quit once their semaphore is gone
+    for (int32 i = 0; i < fWorkerCount; i++)
+        delete_sem(fWorkers[i].sync);
+
+    // Unblock those waiting for the demuxer before waiting for them
+    _StopDemuxer();
+
+    for (int32 i = 0; i < fWorkerCount; i++) {
+        status_t result;
+        wait_for_thread(fWorkers[i].thread, &result);
+    }
+
+    delete[] fWorkers;
+    fWorkers = NULL;
+    fWorkerCount = 0;
 
     fRunning = false;
 }
@@ -745,8 +1802,8 @@ DVDDiskNode::HandleTimeWarp(bigtime_t performance_time)
 {
     fPerformanceTimeBase = performance_time;
 
-    /* Tell frame generation thread to recalculate delay value */
-    release_sem(fStreamSync);
+    /* Tell frame generation threads to recalculate delay value */
+    _WakeWorkers();
 }
 
 void
@@ -754,63 +1811,364 @@ DVDDiskNode::HandleSeek(bigtime_t performance_time)
 {
     fPerformanceTimeBase = performance_time;
 
-    /* Tell frame generation thread to recalculate delay value */
-    release_sem(fStreamSync);
+    /* Tell frame generation threads to recalculate delay value */
+    _WakeWorkers();
+}
+
+/* Escalates the catch-up policy a level at a time, giving each level time
+ * to work before the next. Being late by more than a VOBU skips ahead
+ * right away. */
+void
+DVDDiskNode::_CatchUp(bigtime_t late)
+{
+    BAutolock _(fLock);
+
+    bigtime_t now = system_time();
+    int32 level = fLateLevel;
+
+    fLastLate = now;
+
+    if (late >= DVD_VOBU_TIME)
+        level = max_c(level, DVD_LATE_SKIP_VOBUS);
+    else if (now - fLastEscalation >= DVD_LATE_SETTLE)
+        level = min_c(level + 1, DVD_LATE_ONLY_I);
+
+    // One skip per VOBU time at most, late notices come by the dozen
+    if (level >= DVD_LATE_SKIP_VOBUS && now - fLastSkip >= DVD_LATE_SETTLE) {
+        int32 count = max_c(late / DVD_VOBU_TIME, 1);
+        atomic_set(&fVobuSkip, min_c(count, DVD_MAX_VOBU_SKIP));
+        fLastSkip = now;
+    }
+
+    if (level != fLateLevel) {
+        fLateLevel = level;
+        fLastEscalation = now;
+        _ApplyLateLevel();
+    }
+}
+
+/* Goes back a catch-up level once late notices have stopped for a while. */
+void
+DVDDiskNode::_Recover()
+{
+    if (fLateLevel == DVD_LATE_NONE)
+        return;
+
+    BAutolock _(fLock);
+
+    bigtime_t now = system_time();
+    if (fLateLevel == DVD_LATE_NONE || now - fLastLate < DVD_LATE_RECOVERY
+        || now - fLastEscalation < DVD_LATE_RECOVERY)
+        return;
+
+    fLateLevel--;
+    fLastEscalation = now;
+    _ApplyLateLevel();
+}
+
+/* Hands the catch-up level to the video decoders and reports what was left
+ * out so far. */
+void
+DVDDiskNode::_ApplyLateLevel()
+{
+    int32 mode = DVD_SKIP_NONE;
+    if (fLateLevel >= DVD_LATE_ONLY_I)
+        mode = DVD_SKIP_P;
+    else if (fLateLevel >= DVD_LATE_DROP_B)
+        mode = DVD_SKIP_B;
+
+    int32 dropped = 0;
+    for (uint32 i = 0; i < fDecoders.size(); i++) {
+        if (fStreams[i] != DVD_STREAM_VIDEO)
+            continue;
+
+        fDecoders[i]->SetSkipMode(mode);
+        dropped += fDecoders[i]->CountDropped();
+    }
+
+    PRINTF(1, ("Catch-up level %ld: %ld pictures dropped, %ld VOBUs "
+        "skipped\n", fLateLevel, dropped, atomic_get(&fSkippedVobus)));
 }
 
-/* The following functions form the thread that generates frames. You should
- * replace this with the code that interfaces to your hardware. */
+/* Wakes the worker of an output, or all of them, to recalculate their
+ * delay. */
+void
+DVDDiskNode::_WakeWorkers(int32 output)
+{
+    for (int32 i = 0; i < fWorkerCount; i++) {
+        if (output < 0 || fWorkers[i].output == output)
+            release_sem(fWorkers[i].sync);
+    }
+}
+
+/* The following functions form the threads that generate frames, one per
+ * output. Each decodes its own stream from the demuxer, so a slow output
+ * doesn't hold up the others. */
 int32
-DVDDiskNode::StreamGenerator()
+DVDDiskNode::StreamGenerator(int32 output, sem_id sync)
 {
-    bigtime_t wait_until = system_time();
+    // Stream time the next buffer should start at, -1 when unknown
+    bigtime_t expected = -1;
 
     while (1) {
-        status_t err = acquire_sem_etc(fStreamSync, 1, B_ABSOLUTE_TIMEOUT,
-                wait_until);
+        status_t err;
 
-        BBuffer *buffer = fBufferGroups[0]->RequestBuffer(8147200);
-        if (!buffer)
+        /* Send buffers only if the node is running and the output has been
+         * connected. An output nobody listens to still drains its stream,
+         * the demuxer would stall the other outputs otherwise. */
+        if (!fRunning || !fConnected[output]) {
+            if (fRunning)
+                fDecoders[output]->Skip();
+            expected = -1;
+
+            /* The only acceptable responses are B_OK and B_TIMED_OUT.
+             * Everything else means the thread should quit. Deleting the
+             * semaphore, as in DVDDiskNode::HandleStop(), will trigger this
+             * behavior. */
+            err = acquire_sem_etc(sync, 1, B_RELATIVE_TIMEOUT, 10000);
+            if ((err != B_OK) && (err != B_TIMED_OUT))
+                break;
             continue;
-            
-        /* The only acceptable responses are B_OK and B_TIMED_OUT. Everything
-         * else means the thread should quit. Deleting the semaphore, as in
-         * DVDDiskNode::HandleStop(), will trigger this behavior. */
-        if ((err != B_OK) && (err != B_TIMED_OUT))
+        }
+
+        /* A failed decode or a missing buffer comes back here without
+         * waiting on the semaphore, check it for HandleStop() anyway. */
+        err = acquire_sem_etc(sync, 1, B_RELATIVE_TIMEOUT, 0);
+        if (err != B_OK && err != B_WOULD_BLOCK && err != B_TIMED_OUT)
             break;
 
-        /* If the semaphore was acquired successfully, it means something
-         * changed the timing information (see DVDDiskNode::Connect()) and
-         * so the thread should go back to sleep until the newly-calculated
-         * wait_until time. */
-        if (err == B_OK)
+        _Recover();
+
+        /* The group lock is only held to take a buffer and to send it, so
+         * SetBufferGroup() and Disconnect() don't wait for a decode. A group
+         * replaced in between shows in its generation. */
+        fGroupLocks[output]->Lock();
+
+        // Preroll() may have decoded the first one already
+        int32 flushes = atomic_get(&fFlushes);
+        BBuffer *buffer = fReadyBuffers[output];
+        int64 frameCount = fReadyFrames[output];
+        bool decode = buffer == NULL;
+        fReadyBuffers[output] = NULL;
+
+        if (buffer != NULL)
+            flushes = fReadyFlushes;
+        else if (fBufferGroups[output] != NULL) {
+            buffer = fBufferGroups[output]->RequestBuffer(
+                fBufferSizes[output], DVD_BUFFER_TIMEOUT);
+        }
+
+        int32 generation = fGroupGenerations[output];
+        if (buffer != NULL)
+            fBusyGroups[output] = fBufferGroups[output];
+
+        fGroupLocks[output]->Unlock();
+
+        if (!buffer)
             continue;
 
-        /* Send buffers only if the node is running and the output has been
-         * enabled */
-        if (!fRunning)
+        if (decode) {
+            PRINTF(2, ("Read frames (%ld)\n", output));
+            if (fDecoders[output]->Decode(buffer->Data(), &frameCount,
+                    buffer->Header()) != B_OK) {
+                _ReturnBuffer(output, buffer);
+                continue;
+            }
+        }
+
+        bigtime_t start = _Reschedule(output, buffer->Header()->start_time,
+            frameCount, &expected);
+
+        /* Decoding runs ahead, the buffer waits until it is due downstream.
+         * Acquiring the semaphore means something changed the timing
+         * information (see DVDDiskNode::HandleSeek()), so the wake-up is
+         * calculated again. */
+        do {
+            err = acquire_sem_etc(sync, 1, B_ABSOLUTE_TIMEOUT,
+                _SendTime(output, fPerformanceTimeBase + start));
+        } while (err == B_OK && atomic_get(&fFlushes) == flushes);
+
+        if ((err != B_OK) && (err != B_TIMED_OUT)) {
+            _ReturnBuffer(output, buffer);
+            break;
+        }
+
+        // Navigation dropped the stream this buffer was decoded from
+        if (atomic_get(&fFlushes) != flushes) {
+            _ReturnBuffer(output, buffer);
+            expected = -1;
             continue;
+        }
 
-        BAutolock _(fLock);
+        buffer->Header()->start_time = fPerformanceTimeBase + start;
 
-        int64 frameCount;
-        PRINTF(1, ("Read frames\n"));
-        fTracks[0]->ReadFrames(buffer->Data(), &frameCount, buffer->Header());
-        
-        PRINTF(1, ("Send Buffer\n"));
-        if (SendBuffer(buffer, fOutputs[0]->source, fOutputs[0]->destination) < B_OK) {
+        BAutolock _(fGroupLocks[output]);
+
+        // The output got another group or was disconnected meanwhile
+        if (fGroupGenerations[output] != generation) {
+            buffer->Recycle();
+            _ReleaseGroup(output);
+            expected = -1;
+            continue;
+        }
+
+        PRINTF(2, ("Send Buffer (%ld)\n", output));
+        if (SendBuffer(buffer, fOutputs[output]->source,
+                fOutputs[output]->destination) < B_OK) {
             printf("DVD: StreamGenerator: Error sending buffer\n");
             buffer->Recycle();
         }
+
+        _ReleaseGroup(output);
     }
 
     return B_OK;
 }
 
+/* Turns the decoded time of a buffer into the stream time it goes out for.
+ * Small differences to where the last buffer ended are decoder jitter that
+ * the schedule only drifts towards, bigger ones are real jumps. */
+bigtime_t
+DVDDiskNode::_Reschedule(int32 output, bigtime_t decoded, int64 frameCount,
+        bigtime_t *expected)
+{
+    const media_format &format = fOutputs[output]->format;
+    bigtime_t start = decoded;
+
+    if (*expected >= 0) {
+        bigtime_t drift = decoded - *expected;
+        if (drift > -DVD_MAX_DRIFT && drift < DVD_MAX_DRIFT)
+            start = *expected + drift / DVD_DRIFT_DAMPING;
+    }
+
+    bigtime_t duration;
+    if (format.type == B_MEDIA_RAW_VIDEO)
+        duration = frameCount * _BufferDuration(format, 0);
+    else if (format.u.raw_audio.frame_rate > 0)
+        duration = (bigtime_t)(frameCount * 1000000.0
+            / format.u.raw_audio.frame_rate);
+    else
+        duration = _BufferDuration(format, fBufferSizes[output]);
+
+    *expected = start + duration;
+    return start;
+}
+
+/* When a buffer for 'performanceTime' has to leave to get downstream in
+ * time. The scheduling latency is the slack for waking up late. */
+bigtime_t
+DVDDiskNode::_SendTime(int32 output, bigtime_t performanceTime)
+{
+    BTimeSource *timeSource = TimeSource();
+    if (timeSource == NULL || !timeSource->IsRunning())
+        return system_time();
+
+    return timeSource->RealTimeFor(performanceTime,
+        fLatencies[output] + SchedulingLatency());
+}
+
 int32
 DVDDiskNode::_stream_generator_(void *data)
 {
-    return ((DVDDiskNode *)data)->StreamGenerator();
+    output_worker *worker = (output_worker *)data;
+    return worker->node->StreamGenerator(worker->output, worker->sync);
+}
+
+/* Moves the program stream from the read cursor into the demuxer's stream
+ * rings, one span at a time. A full ring holds the whole stream up, the
+ * outputs are all fed from the same pass over the data. */
+int32
+DVDDiskNode::DemuxLoop()
+{
+    while (fDemuxing) {
+        fReadLock.Lock();
+
+        // libdvdnav would start over from the first play PGC, only
+        // navigation moves on from the end, see _FlushStream()
+        if (fStopped) {
+            fReadLock.Unlock();
+            acquire_sem(fPauseSem);
+            continue;
+        }
+
+        if (fDemuxed >= fSpanLength) {
+            status_t status = _NextSpan(true);
+            if (status != B_OK) {
+                bigtime_t wake = fPauseWake;
+                if (status == B_LAST_BUFFER_ERROR)
+                    fStopped = true;
+                fReadLock.Unlock();
+
+                if (status == B_LAST_BUFFER_ERROR)
+                    continue;
+
+                // Held up by a still or a wait, navigation wakes us early
+                if (status == B_WOULD_BLOCK) {
+                    acquire_sem_etc(fPauseSem, 1, B_ABSOLUTE_TIMEOUT,
+                        min_c(wake, system_time() + DVD_PAUSE_POLL));
+                } else
+                    snooze(10000);
+                continue;
+            }
+        }
+
+        ssize_t taken = fDemuxer->Demux(fSpan + fDemuxed,
+            fSpanLength - fDemuxed);
+        fDemuxed += taken;
+        bool blocked = fDemuxed < fSpanLength;
+
+        fReadLock.Unlock();
+
+        if (blocked)
+            fDemuxer->WaitForSpace(50000);
+    }
+
+    return B_OK;
+}
+
+/* The demuxer runs from Preroll() or HandleStart(), whichever comes first,
+ * until HandleStop(). */
+status_t
+DVDDiskNode::_StartDemuxer()
+{
+    if (fDemuxing)
+        return B_OK;
+
+    // Starting the node again plays the disc from the start
+    fStopped = false;
+    fDemuxing = true;
+    fDemuxThread = spawn_thread(_demuxer_, "dvd demuxer",
+            B_NORMAL_PRIORITY, this);
+    if (fDemuxThread < B_OK) {
+        fDemuxing = false;
+        return fDemuxThread;
+    }
+
+    resume_thread(fDemuxThread);
+    return B_OK;
+}
+
+void
+DVDDiskNode::_StopDemuxer()
+{
+    if (!fDemuxing)
+        return;
+
+    fDemuxing = false;
+    // It may be waiting for navigation
+    release_sem(fPauseSem);
+    // The workers may be waiting for the rings it fills
+    if (fDemuxer != NULL)
+        fDemuxer->WakeReaders();
+
+    status_t result;
+    wait_for_thread(fDemuxThread, &result);
+}
+
+int32
+DVDDiskNode::_demuxer_(void *data)
+{
+    return ((DVDDiskNode *)data)->DemuxLoop();
 }
 
 bool
@@ -19,6 +19,8 @@
 #include <vector>
 
 #include "dvdnav.h"
+#include "DVDDemuxer.h"
+#include "DVDNavigation.h"
 
 class DVDDiskNode :
     public virtual BPositionIO,
@@ -126,6 +128,38 @@ private:
 
         void        LoadDisk();
         void        InitOutputs();
+        status_t    _AddStream(int32 stream, const media_format *encoded,
+                        media_format *decoded);
+        void        _AddOutput(media_output *output);
+
+        // Buffer groups sized from the negotiated formats
+        size_t      _BufferSize(const media_format &format) const;
+        bigtime_t   _BufferDuration(const media_format &format,
+                        size_t size) const;
+        status_t    _CreateBufferGroup(int32 output);
+        void        _SetBufferGroup(int32 output, BBufferGroup *group,
+                        bool own);
+        void        _ReturnBuffer(int32 output, BBuffer *buffer);
+        void        _ReleaseGroup(int32 output);
+
+        // Read cursor over the program stream
+        void        _ReleaseSpan();
+        status_t    _NextSpan(bool hold = false);
+        void        _HandleNavPacket();
+        void        _HandleEvent(int32 event, const uint8 *data);
+        status_t    _EndPause(bool hold);
+        status_t    _SeekStream(off_t pos);
+
+        // Navigation commands from HandleMessage()
+        status_t    _Navigate(int32 message,
+                        const dvd_nav_command *command);
+        status_t    _ReplyState(port_id port);
+        void        _FlushStream();
+        bigtime_t   _OutputLatency();
+
+        // Offset to sector index of the current program chain
+        status_t    _BuildIndex();
+        void        _FreeIndex();
 
         status_t            fInitStatus;
 
@@ -134,15 +168,61 @@ private:
 
         BLocker             fLock;
 
-        thread_id           fThread;
-        sem_id              fStreamSync;
+        // Every output has a worker thread with its own timing semaphore
+        struct output_worker {
+            DVDDiskNode     *node;
+            int32           output;
+            thread_id       thread;
+            sem_id          sync;
+        };
+
+        output_worker       *fWorkers;
+        int32               fWorkerCount;
 static  int32               _stream_generator_(void *data);
-        int32               StreamGenerator();
+        int32               StreamGenerator(int32 output, sem_id sync);
+        void                _WakeWorkers(int32 output = -1);
+        bigtime_t           _Reschedule(int32 output, bigtime_t decoded,
+                                int64 frameCount, bigtime_t *expected);
+        bigtime_t           _SendTime(int32 output,
+                                bigtime_t performanceTime);
+
+        // Catching up after late notices
+        void                _CatchUp(bigtime_t late);
+        void                _Recover();
+        void                _ApplyLateLevel();
+        bool                _SkipVobus();
+
+        int32               fLateLevel;
+        bigtime_t           fLastLate;
+        bigtime_t           fLastEscalation;
+        bigtime_t           fLastSkip;
+        int32               fVobuSkip;
+        int32               fSkippedVobus;
+
+        thread_id           fDemuxThread;
+        volatile bool       fDemuxing;
+static  int32               _demuxer_(void *data);
+        int32               DemuxLoop();
+        status_t            _StartDemuxer();
+        void                _StopDemuxer();
+        void                _PrepareBuffer(int32 output);
 
 		std::vector<media_output *>	fOutputs;
         std::vector<BBufferGroup *> fBufferGroups;
-        std::vector<BMediaTrack *>  fTracks;
         std::vector<bool>           fConnected;
+        std::vector<int32>          fStreams;
+        std::vector<size_t>         fBufferSizes;
+        std::vector<bigtime_t>      fLatencies;
+        std::vector<BBuffer *>      fReadyBuffers;
+        std::vector<int64>          fReadyFrames;
+        int32                       fReadyFlushes;
+        int32                       fFlushes;
+        std::vector<bool>           fOwnGroups;
+        std::vector<BLocker *>      fGroupLocks;
+        std::vector<int32>          fGroupGenerations;
+        std::vector<BBufferGroup *> fBusyGroups;
+        std::vector<BBufferGroup *> fRetiredGroups;
+        std::vector<DVDStreamDecoder *> fDecoders;
 
         bigtime_t           fPerformanceTimeBase;
         bigtime_t           fProcessingLatency;
@@ -154,15 +234,44 @@ static  int32               _stream_generator_(void *data);
         int32               fDriveIndex;
 
         dvdnav_t            *fDVDNav;
-        BMediaFile          *fMediaFile;
+        DVDDemuxer          *fDemuxer;
         
         int                 fResult;
         int                 fEvent;
         int                 fLen;
         uint8_t             *fBuffer;
         int                 fBufferSize;
-		size_t	            fPosition;
-		size_t	            fLength;
+		off_t	            fPosition;
+		off_t	            fLength;
+
+        BLocker             fReadLock;
+        uint8_t             *fSpan;
+        size_t              fSpanLength;
+        off_t               fSpanStart;
+        bool                fResync;
+        size_t              fDemuxed;
+        // Playback came to its end, the demuxer waits for navigation
+        bool                fStopped;
+
+        // Stills and waits hold the read cursor, see _EndPause()
+        int32               fPause;
+        int32               fStillLength;
+        bigtime_t           fPauseStart;
+        bigtime_t           fPauseEnd;
+        bigtime_t           fPauseWake;
+        sem_id              fPauseSem;
+
+        // Presentation state from the libdvdnav events, under fLock
+        uint32              fClut[16];
+        dvdnav_highlight_area_t fHighlight;
+        int32               fButtonCount;
+        int32               fAudioStream;
+        int32               fSpuStream;
+
+        uint32_t            *fVobuIndex;
+        uint32_t            fVobuCount;
+        int32_t             fIndexTitle;
+        int64_t             fIndexPGCLength;
 };
 
 #endif
@@ -0,0 +1,66 @@
+#ifndef DVD_NAVIGATION_H
+#define DVD_NAVIGATION_H
+
+#include <OS.h>
+#include <SupportDefs.h>
+
+/* Navigation commands for the DVD node, written to its control port along
+ * with a dvd_nav_command, e.g.
+ *
+ *     write_port(node.port, DVD_NAV_PART_PLAY, &command, sizeof(command));
+ *
+ * Commands that move playback drop whatever was read for the old position,
+ * so the new one shows up within about a VOBU (half a second). */
+enum {
+    DVD_NAV_TITLE_PLAY      = 'dvTP',   // title
+    DVD_NAV_PART_PLAY       = 'dvPP',   // title, value: part
+    DVD_NAV_TIME_SEARCH     = 'dvTS',   // time: 90kHz ticks into the title
+    DVD_NAV_PREV_PART       = 'dvPv',
+    DVD_NAV_NEXT_PART       = 'dvNx',
+    DVD_NAV_MENU_CALL       = 'dvMC',   // value: DVDMenuID_t
+    DVD_NAV_GO_UP           = 'dvGU',
+    DVD_NAV_BUTTON_SELECT   = 'dvBS',   // value: button
+    DVD_NAV_BUTTON_ACTIVATE = 'dvBA',
+    DVD_NAV_BUTTON_UP       = 'dvBU',
+    DVD_NAV_BUTTON_DOWN     = 'dvBD',
+    DVD_NAV_BUTTON_LEFT     = 'dvBL',
+    DVD_NAV_BUTTON_RIGHT    = 'dvBR',
+    DVD_NAV_ANGLE_CHANGE    = 'dvAC',   // value: angle
+
+    // Takes a dvd_nav_state_request instead, the node writes a
+    // dvd_nav_state to its reply port under DVD_NAV_STATE
+    DVD_NAV_GET_STATE       = 'dvGS',
+    DVD_NAV_STATE           = 'dvSt'
+};
+
+struct dvd_nav_command {
+    int32       title;
+    int32       value;
+    int64       time;
+};
+
+struct dvd_nav_state_request {
+    port_id     reply_port;
+};
+
+/* What libdvdnav wants presented right now. The node has an output for
+ * each audio stream of the title, 'audio_output' is the media_source id of
+ * the one to play, -1 if there is none. The node has no subpicture
+ * output and drops their packets, the subpicture fields only tell what the
+ * disc asks for, e.g. to draw the highlighted menu button. */
+struct dvd_nav_state {
+    int32       audio_stream;       // physical, -1 for none
+    int32       audio_output;
+    int32       spu_stream;         // physical, -1 for none
+    uint32      clut[16];           // YCrCb
+
+    int32       button_count;
+    int32       button;             // highlighted, 0 for none
+    uint32      button_palette;     // 4 bits per entry
+    uint16      button_left;
+    uint16      button_top;
+    uint16      button_right;
+    uint16      button_bottom;
+};
+
+#endif
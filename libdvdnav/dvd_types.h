@@ -61,6 +61,38 @@ typedef struct {
 } dvdnav_highlight_area_t;
 
 
+/*
+ * Read-ahead cache counters, cumulative since dvdnav_open()
+ * (see dvdnav_get_cache_stats())
+ */
+typedef struct {
+  uint64_t hits;            /* blocks handed out from the cache or the image mapping */
+  uint64_t misses;          /* blocks read directly on the caller's thread */
+  uint64_t bytes_read;      /* bytes returned by DVDReadBlocks() */
+  uint64_t read_calls;      /* calls to DVDReadBlocks() */
+  uint64_t read_time;       /* microseconds spent in DVDReadBlocks() */
+  uint64_t wait_time;       /* microseconds readers waited for the read-ahead */
+  uint32_t read_ahead_size; /* current read-ahead step in blocks */
+  uint32_t arena_allocs;    /* times the arena was allocated */
+  uint32_t chunks;          /* chunks in the arena */
+  uint32_t chunks_in_use;   /* chunks with blocks handed out and not returned */
+} dvdnav_cache_stats_t;
+
+/*
+ * A PES packet of a program stream pack (see dvdnav_get_pes_packet())
+ */
+typedef struct {
+  uint8_t  stream_id;      /* PES stream id, 0xE0 video, 0xC0-0xC7 MPEG audio,
+                              0xBD private stream 1 */
+  uint8_t  substream_id;   /* private stream 1 substream: 0x20-0x3F subpicture,
+                              0x80-0x87 AC3, 0x88-0x8F DTS, 0xA0-0xA7 LPCM */
+  uint8_t  has_pts;        /* 1 if pts is valid */
+  int64_t  pts;            /* presentation time stamp, 90kHz */
+  const uint8_t *payload;  /* elementary stream data, substream header skipped */
+  uint32_t payload_length;
+} dvdnav_pes_packet_t;
+
+
 /* the following types are currently unused */
 
 #if 0
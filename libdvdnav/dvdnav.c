@@ -54,6 +54,7 @@ static dvdnav_status_t dvdnav_clear(dvdnav_t * this) {
   /* clear everything except file, vm, mutex, readahead */
 
   pthread_mutex_lock(&this->vm_lock);
+  dvdnav_read_cache_clear(this->cache);
   if (this->file) DVDCloseFile(this->file);
   this->file = NULL;
 
@@ -70,7 +71,6 @@ static dvdnav_status_t dvdnav_clear(dvdnav_t * this) {
   this->started = 0;
   this->cur_cell_time = 0;
 
-  dvdnav_read_cache_clear(this->cache);
   pthread_mutex_unlock(&this->vm_lock);
 
   return DVDNAV_STATUS_OK;
@@ -138,6 +138,8 @@ dvdnav_status_t dvdnav_close(dvdnav_t *this) {
 
   if (this->file) {
     pthread_mutex_lock(&this->vm_lock);
+    /* stop the read-ahead before its file goes away */
+    dvdnav_read_cache_clear(this->cache);
     DVDCloseFile(this->file);
 #ifdef LOG_DEBUG
     fprintf(MSG_OUT, "libdvdnav: close:file closing\n");
@@ -227,17 +229,15 @@ int64_t dvdnav_convert_time(dvd_time_t *time) {
 }
 
 /*
- * Returns 1 if block contains NAV packet, 0 otherwise.
- * Processes said NAV packet if present.
+ * Skips the pack header and the system header at the start of a program
+ * stream block. Returns the first PES packet, NULL if there is none.
  *
  * Most of the code in here is copied from xine's MPEG demuxer
  * so any bugs which are found in that should be corrected here also.
  */
-static int32_t dvdnav_decode_packet(dvdnav_t *this, uint8_t *p, dsi_t *nav_dsi, pci_t *nav_pci) {
+static uint8_t *dvdnav_pes_start(uint8_t *p) {
   int32_t        bMpeg1 = 0;
   uint32_t       nHeaderLen;
-  uint32_t       nPacketLen;
-  uint32_t       nStreamID;
 
   if (p[3] == 0xBA) { /* program stream pack header */
     int32_t nStuffingBytes;
@@ -260,9 +260,25 @@ static int32_t dvdnav_decode_packet(dvdnav_t *this, uint8_t *p, dsi_t *nav_dsi,
   /* we should now have a PES packet here */
   if (p[0] || p[1] || (p[2] != 1)) {
     fprintf(MSG_OUT, "libdvdnav: demux error! %02x %02x %02x (should be 0x000001) \n",p[0],p[1],p[2]);
-    return 0;
+    return NULL;
   }
 
+  return p;
+}
+
+/*
+ * Returns 1 if block contains NAV packet, 0 otherwise.
+ * Processes said NAV packet if present.
+ */
+static int32_t dvdnav_decode_packet(dvdnav_t *this, uint8_t *p, dsi_t *nav_dsi, pci_t *nav_pci) {
+  uint32_t       nHeaderLen;
+  uint32_t       nPacketLen;
+  uint32_t       nStreamID;
+
+  p = dvdnav_pes_start(p);
+  if (!p)
+    return 0;
+
   nPacketLen = p[4] << 8 | p[5];
   nStreamID  = p[3];
 
@@ -295,6 +311,67 @@ static int32_t dvdnav_decode_packet(dvdnav_t *this, uint8_t *p, dsi_t *nav_dsi,
   return 0;
 }
 
+dvdnav_status_t dvdnav_get_pes_packet(dvdnav_t *this, const uint8_t *block, dvdnav_pes_packet_t *pes) {
+  uint8_t  *p, *end;
+  uint32_t nPacketLen;
+  uint32_t nHeaderLen;
+
+  memset(pes, 0, sizeof(dvdnav_pes_packet_t));
+
+  p = dvdnav_pes_start((uint8_t *)block);
+  if (!p) {
+    printerr("Block holds no PES packet.");
+    return DVDNAV_STATUS_ERR;
+  }
+
+  nPacketLen = p[4] << 8 | p[5];
+  end = p + 6 + nPacketLen;
+  if (end > block + DVD_VIDEO_LB_LEN) {
+    printerr("PES packet runs past the block.");
+    return DVDNAV_STATUS_ERR;
+  }
+  pes->stream_id = p[3];
+
+  if (pes->stream_id == 0xbe || pes->stream_id == 0xbf) {
+    /* padding and private stream 2 (NAV) have no PES header extension */
+    p += 6;
+  } else {
+    if ((p[6] & 0xc0) != 0x80) {
+      printerr("Not an MPEG-2 PES packet.");
+      return DVDNAV_STATUS_ERR;
+    }
+    if (p[7] & 0x80) {
+      pes->has_pts = 1;
+      pes->pts  = (int64_t)((p[9] >> 1) & 0x07) << 30;
+      pes->pts |= p[10] << 22;
+      pes->pts |= (p[11] >> 1) << 15;
+      pes->pts |= p[12] << 7;
+      pes->pts |= p[13] >> 1;
+    }
+    nHeaderLen = p[8];
+    p += 9 + nHeaderLen;
+  }
+
+  if (pes->stream_id == 0xbd && p < end) { /* Private stream 1 */
+    pes->substream_id = p[0];
+    if (p[0] >= 0x80 && p[0] <= 0x8f)      /* AC3, DTS: frame count, first access unit */
+      p += 4;
+    else if (p[0] >= 0xa0 && p[0] <= 0xaf) /* LPCM: also the audio frame header */
+      p += 7;
+    else
+      p += 1;
+  }
+
+  if (p > end) {
+    printerr("PES header runs past the packet.");
+    return DVDNAV_STATUS_ERR;
+  }
+  pes->payload = p;
+  pes->payload_length = end - p;
+
+  return DVDNAV_STATUS_OK;
+}
+
 /* DSI is used for most angle stuff.
  * PCI is used for only non-seemless angle stuff
  */
@@ -407,8 +484,11 @@ int64_t dvdnav_get_current_time(dvdnav_t *this) {
   return tm;
 }
 
-dvdnav_status_t dvdnav_get_next_cache_block(dvdnav_t *this, uint8_t **buf,
-					    int32_t *event, int32_t *len) {
+/* Does the work for both cache variants: a DVDNAV_BLOCK_OK hands out up to
+ * 'max_blocks' blocks of the current VOBU in one go. */
+static dvdnav_status_t dvdnav_get_next_cache_blocks(dvdnav_t *this, uint8_t **buf,
+						    int32_t *event, int32_t *len,
+						    int32_t max_blocks) {
   dvd_state_t *state;
   int32_t result;
 
@@ -530,6 +610,7 @@ dvdnav_status_t dvdnav_get_next_cache_block(dvdnav_t *this, uint8_t **buf,
     int32_t vtsN;
     dvdnav_vts_change_event_t *vts_event = (dvdnav_vts_change_event_t *)*buf;
 
+    dvdnav_read_cache_clear(this->cache);
     if(this->file) {
       DVDCloseFile(this->file);
       this->file = NULL;
@@ -561,7 +642,6 @@ dvdnav_status_t dvdnav_get_next_cache_block(dvdnav_t *this, uint8_t **buf,
 
     this->position_current.vts = this->position_next.vts;
     this->position_current.domain = this->position_next.domain;
-    dvdnav_read_cache_clear(this->cache);
     this->file = DVDOpenFile(vm_get_dvd_reader(this->vm), vtsN, domain);
     vts_event->new_vtsN = this->position_next.vts;
     vts_event->new_domain = this->position_next.domain;
@@ -812,19 +892,39 @@ dvdnav_status_t dvdnav_get_next_cache_block(dvdnav_t *this, uint8_t **buf,
   }
 
   this->vobu.blockN++;
-  result = dvdnav_read_cache_block(this->cache, this->vobu.vobu_start + this->vobu.blockN, 1, buf);
+  if (max_blocks > 1) {
+    /* never run past the next NAV packet */
+    int32_t blocks = this->vobu.vobu_length - this->vobu.blockN + 1;
+
+    if (blocks > max_blocks)
+      blocks = max_blocks;
+    result = dvdnav_read_cache_span(this->cache, this->vobu.vobu_start + this->vobu.blockN, blocks, buf);
+  } else {
+    result = dvdnav_read_cache_block(this->cache, this->vobu.vobu_start + this->vobu.blockN, 1, buf);
+  }
   if(result <= 0) {
     printerr("Error reading from DVD.");
     pthread_mutex_unlock(&this->vm_lock);
     return DVDNAV_STATUS_ERR;
   }
+  this->vobu.blockN += result / DVD_VIDEO_LB_LEN - 1;
   (*event) = DVDNAV_BLOCK_OK;
-  (*len) = 2048;
+  (*len) = result;
 
   pthread_mutex_unlock(&this->vm_lock);
   return DVDNAV_STATUS_OK;
 }
 
+dvdnav_status_t dvdnav_get_next_cache_block(dvdnav_t *this, uint8_t **buf,
+					    int32_t *event, int32_t *len) {
+  return dvdnav_get_next_cache_blocks(this, buf, event, len, 1);
+}
+
+dvdnav_status_t dvdnav_get_next_cache_span(dvdnav_t *this, uint8_t **buf,
+					   int32_t *event, int32_t *len) {
+  return dvdnav_get_next_cache_blocks(this, buf, event, len, INT32_MAX);
+}
+
 dvdnav_status_t dvdnav_get_title_string(dvdnav_t *this, const char **title_str) {
   (*title_str) = this->vm->dvd_name;
   return DVDNAV_STATUS_OK;
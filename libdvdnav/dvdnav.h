@@ -151,11 +151,12 @@ dvdnav_status_t dvdnav_get_region_mask(dvdnav_t *self, int32_t *region_mask);
  * Specify whether read-ahead caching should be used. You may not want this if your
  * decoding engine does its own buffering.
  *
- * The default read-ahead cache does not use an additional thread for the reading
- * (see read_cache.c for a threaded cache, but note that this code is currently
- * unmaintained). It prebuffers on VOBU level by reading ahead several buffers
- * on every read request. The speed of this prebuffering has been optimized to
- * also work on slow DVD drives.
+ * The read-ahead cache prebuffers on VOBU level: once a NAV packet announces
+ * the next VOBU, background threads read it in steps of growing size while
+ * the application consumes the sectors that have already arrived. During
+ * sequential playback the following VOBUs are read at the same time, so that
+ * several reads are in flight. The step size has been optimized to also work
+ * on slow DVD drives.
  *
  * If in addition you want to prevent memcpy's to improve performance, have a look
  * at dvdnav_get_next_cache_block().
@@ -167,6 +168,36 @@ dvdnav_status_t dvdnav_set_readahead_flag(dvdnav_t *self, int32_t read_ahead_fla
  */
 dvdnav_status_t dvdnav_get_readahead_flag(dvdnav_t *self, int32_t *read_ahead_flag);
 
+/*
+ * Sets up the memory of the read-ahead cache. The cache is a single arena of
+ * at most 'max_bytes' bytes, cut into slabs of 'chunk_blocks' blocks of which
+ * each holds one VOBU. It is allocated once, when the read-ahead is first
+ * used, and never grows afterwards. Passing 0 keeps the respective default
+ * (8 slabs of 640 blocks, about 10 MB).
+ *
+ * This fails while blocks obtained with dvdnav_get_next_cache_block() have not
+ * been returned with dvdnav_free_cache_block().
+ */
+dvdnav_status_t dvdnav_set_cache_config(dvdnav_t *self, size_t max_bytes, size_t chunk_blocks);
+
+/*
+ * Fills 'stats' with the counters of the read-ahead cache: blocks served
+ * from the cache and read directly, the reads issued and the time spent in
+ * them, the time the caller was kept waiting for the read-ahead, and the
+ * current read-ahead step and chunk usage. A growing 'wait_time' means the
+ * drive cannot keep up with the consumer.
+ */
+dvdnav_status_t dvdnav_get_cache_stats(dvdnav_t *self, dvdnav_cache_stats_t *stats);
+
+/*
+ * Asks the read-ahead for the 'block_count' blocks following the NAV packet
+ * of the current VOBU, e.g. to warm up the cache before playback starts.
+ * At most half of the cache is queued at once. Does nothing when read-ahead
+ * is off. Fails when no NAV packet has been read since the start or the
+ * last jump.
+ */
+dvdnav_status_t dvdnav_pre_cache(dvdnav_t *self, uint32_t block_count);
+
 /*
  * Specify whether the positioning works PGC or PG based.
  * Programs (PGs) on DVDs are similar to Chapters and a program chain (PGC)
@@ -215,10 +246,23 @@ dvdnav_status_t dvdnav_get_next_block(dvdnav_t *self, uint8_t *buf,
  * the one handed in, pointing directly into the relevant block in the cache.
  * Those pointers must _never_ be freed but instead returned to the library via
  * dvdnav_free_cache_block().
+ * When the DVD is an unencrypted image file, the pointers may point directly
+ * into a memory mapping of the image, which stays valid until dvdnav_close().
  */
 dvdnav_status_t dvdnav_get_next_cache_block(dvdnav_t *self, uint8_t **buf,
                         int32_t *event, int32_t *len);
 
+/*
+ * Like dvdnav_get_next_cache_block(), but a DVDNAV_BLOCK_OK event hands out
+ * a whole span of blocks at once: all blocks up to the next NAV packet that
+ * are contiguous in the cache (or the memory mapped image) and have already
+ * been read, at least one. 'len' is then a multiple of 2048. The buffer
+ * handed in still only has to take a single block, which is used on a cache
+ * miss. Spans are returned with a single dvdnav_free_cache_block() call.
+ */
+dvdnav_status_t dvdnav_get_next_cache_span(dvdnav_t *self, uint8_t **buf,
+                        int32_t *event, int32_t *len);
+
 /*
  * All buffers which came from the internal cache (when dvdnav_get_next_cache_block()
  * returned a buffer different from the one handed in) have to be freed with this
@@ -226,6 +270,15 @@ dvdnav_status_t dvdnav_get_next_cache_block(dvdnav_t *self, uint8_t **buf,
  */
 dvdnav_status_t dvdnav_free_cache_block(dvdnav_t *self, unsigned char *buf);
 
+/*
+ * Parses the PES packet in a 2048 byte program stream block, as returned
+ * by the functions above, the same way libdvdnav finds NAV packets. The
+ * payload in 'pes' points into 'block'. For private stream 1 the substream
+ * header (and the LPCM audio frame header) is skipped.
+ */
+dvdnav_status_t dvdnav_get_pes_packet(dvdnav_t *self, const uint8_t *block,
+                        dvdnav_pes_packet_t *pes);
+
 /*
  * If we are currently in a still-frame this function skips it.
  *
@@ -299,6 +352,17 @@ dvdnav_status_t dvdnav_part_play(dvdnav_t *self, int32_t title, int32_t part);
  */
 uint32_t dvdnav_describe_title_chapters(dvdnav_t *self, int32_t title, uint64_t **times, uint64_t *duration);
 
+/*
+ * Stores in *vobus an array (that the application *must* free) of the
+ * starts of all VOBUs in the current program chain (or program, see
+ * dvdnav_set_PGC_positioning_flag()), in ascending order. The starts are
+ * block offsets in the space used by dvdnav_sector_search(): the cells one
+ * after the other, other angles left out. *length is the length of that
+ * space in blocks. The number of entries in *vobus is the result of the
+ * function. On error *vobus is NULL and the output is 0
+ */
+uint32_t dvdnav_describe_pgc_vobus(dvdnav_t *self, uint32_t **vobus, uint32_t *length);
+
 /*
  * Play the specified amount of parts of the specified title of
  * the DVD then STOP.
@@ -422,6 +486,9 @@ dvdnav_status_t dvdnav_next_pg_search(dvdnav_t *self);
  * If program chain based positioning is enabled
  * (see dvdnav_set_PGC_positioning_flag()), this will return the
  * relative position in and the length of the current program chain.
+ *
+ * Of an angle block only the first cell is counted, a position in another
+ * angle is given as the same offset into the first one.
  */
 dvdnav_status_t dvdnav_get_position(dvdnav_t *self, uint32_t *pos,
                     uint32_t *len);
@@ -17,12 +17,25 @@
  * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111, USA.
  */
 
+/* O_DIRECT is a GNU extension in glibc's <fcntl.h>. */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
 #include "config.h"
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifndef WIN32
+#include <sys/mman.h>
+#endif
+#include <pthread.h>
 
 #include "dvd_reader.h"
 #include "dvd_input.h"
@@ -30,11 +43,15 @@
 
 /* The function pointers that is the exported interface of this file. */
 dvd_input_t (*dvdinput_open)  (const char *);
+dvd_input_t (*dvdinput_open_image) (const char *);
 int         (*dvdinput_close) (dvd_input_t);
 int         (*dvdinput_seek)  (dvd_input_t, int);
 int         (*dvdinput_title) (dvd_input_t, int);
 int         (*dvdinput_read)  (dvd_input_t, void *, int, int);
+int         (*dvdinput_pread) (dvd_input_t, void *, int, int, int);
 char *      (*dvdinput_error) (dvd_input_t);
+const unsigned char *(*dvdinput_map) (dvd_input_t, int, int);
+int         (*dvdinput_advise) (dvd_input_t, int, int);
 
 #ifdef HAVE_DVDCSS_DVDCSS_H
 /* linking to libdvdcss */
@@ -68,9 +85,26 @@ static char *        (*DVDcss_error) (dvdcss_handle);
 struct dvd_input_s {
   /* libdvdcss handle */
   dvdcss_handle dvdcss;
+  /* libdvdcss only has a seek and read pair, this keeps them together */
+  pthread_mutex_t css_lock;
 
   /* dummy file input */
   int fd;
+
+  /* opened with O_DIRECT, reads bypass the page cache */
+  int direct;
+
+  /* memory mapping of a regular file, NULL if it could not be mapped */
+  unsigned char *map;
+  off_t map_size;
+  off_t map_pos;
+
+  /* sector aligned buffer for direct reads meant for an unaligned one,
+   * kept for the next one */
+  pthread_mutex_t bounce_lock;
+  unsigned char *bounce_base;
+  unsigned char *bounce;
+  size_t bounce_size;
 };
 
 
@@ -95,6 +129,7 @@ static dvd_input_t css_open(const char *target)
     free(dev);
     return NULL;
   }
+  pthread_mutex_init(&dev->css_lock, NULL);
 
   return dev;
 }
@@ -132,6 +167,41 @@ static int css_read(dvd_input_t dev, void *buffer, int blocks, int flags)
   return DVDcss_read(dev->dvdcss, buffer, blocks, flags);
 }
 
+/**
+ * read data from a given block of the device.
+ */
+static int css_pread(dvd_input_t dev, void *buffer, int block, int blocks,
+                     int flags)
+{
+  int ret;
+
+  pthread_mutex_lock(&dev->css_lock);
+  ret = DVDcss_seek(dev->dvdcss, block, DVDINPUT_NOFLAGS);
+  if(ret == block)
+    ret = DVDcss_read(dev->dvdcss, buffer, blocks, flags);
+  else if(ret >= 0)
+    ret = -1;
+  pthread_mutex_unlock(&dev->css_lock);
+
+  return ret;
+}
+
+/**
+ * libdvdcss may have to decrypt, so its blocks are never mapped.
+ */
+static const unsigned char *css_map(dvd_input_t dev, int block, int blocks)
+{
+  return NULL;
+}
+
+/**
+ * read-ahead hint, libdvdcss does its own reading.
+ */
+static int css_advise(dvd_input_t dev, int block, int blocks)
+{
+  return 0;
+}
+
 /**
  * close the DVD device and clean up the library.
  */
@@ -144,11 +214,37 @@ static int css_close(dvd_input_t dev)
   if(ret < 0)
     return ret;
 
+  pthread_mutex_destroy(&dev->css_lock);
   free(dev);
 
   return 0;
 }
 
+/* Set from DVDREAD_DIRECT_IO by dvdinput_setup(). */
+static int use_direct_io = 0;
+
+/**
+ * switch a direct input back to buffered reads, when the filesystem or the
+ * device refuses a direct read.  Returns 1 if the read should be retried.
+ */
+static int file_drop_direct(dvd_input_t dev)
+{
+#ifdef O_DIRECT
+  int flags;
+
+  if(!dev->direct)
+    return 0;
+  dev->direct = 0;
+  flags = fcntl(dev->fd, F_GETFL);
+  if(flags < 0 || fcntl(dev->fd, F_SETFL, flags & ~O_DIRECT) < 0)
+    return 0;
+  fprintf(stderr, "libdvdread: Direct reads refused, using buffered reads.\n");
+  return 1;
+#else
+  return 0;
+#endif
+}
+
 /**
  * initialize and open a DVD device or file.
  */
@@ -164,8 +260,18 @@ static dvd_input_t file_open(const char *target)
   }
 
   /* Open the device */
+  dev->direct = 0;
 #ifndef WIN32
-  dev->fd = open(target, O_RDONLY);
+  dev->fd = -1;
+#ifdef O_DIRECT
+  if(use_direct_io) {
+    dev->fd = open(target, O_RDONLY | O_DIRECT);
+    dev->direct = dev->fd >= 0;
+  }
+#endif
+  /* Not every filesystem takes O_DIRECT, fall back to a plain open. */
+  if(dev->fd < 0)
+    dev->fd = open(target, O_RDONLY);
 #else
   dev->fd = open(target, O_RDONLY | O_BINARY);
 #endif
@@ -175,6 +281,52 @@ static dvd_input_t file_open(const char *target)
     return NULL;
   }
 
+  dev->map = NULL;
+  dev->map_size = 0;
+  dev->map_pos = 0;
+
+  pthread_mutex_init(&dev->bounce_lock, NULL);
+  dev->bounce_base = NULL;
+  dev->bounce = NULL;
+  dev->bounce_size = 0;
+
+  return dev;
+}
+
+/**
+ * initialize and open a DVD image or device.  An image in a regular file
+ * is read through a memory mapping, devices are not mappable and keep using
+ * read().  Only images are mapped: a VOB file on a mounted disc would turn
+ * a read error into SIGBUS.  A direct input is never mapped, the mapping
+ * would go through the page cache.
+ */
+static dvd_input_t file_open_image(const char *target)
+{
+  dvd_input_t dev;
+
+  dev = file_open(target);
+  if(dev == NULL)
+    return NULL;
+
+#ifndef WIN32
+  if(!dev->direct) {
+    struct stat st;
+
+    if(fstat(dev->fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0
+       && (off_t)(size_t)st.st_size == st.st_size) {
+      void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED,
+                       dev->fd, 0);
+      if(map != MAP_FAILED) {
+        dev->map = (unsigned char *)map;
+        dev->map_size = st.st_size;
+#ifdef POSIX_MADV_SEQUENTIAL
+        posix_madvise(dev->map, (size_t)dev->map_size, POSIX_MADV_SEQUENTIAL);
+#endif
+      }
+    }
+  }
+#endif
+
   return dev;
 }
 
@@ -194,6 +346,11 @@ static int file_seek(dvd_input_t dev, int blocks)
 {
   off_t pos;
 
+  if(dev->map) {
+    dev->map_pos = (off_t)blocks * (off_t)DVD_VIDEO_LB_LEN;
+    return blocks;
+  }
+
   pos = lseek(dev->fd, (off_t)blocks * (off_t)DVD_VIDEO_LB_LEN, SEEK_SET);
   if(pos < 0) {
       return pos;
@@ -210,6 +367,30 @@ static int file_title(dvd_input_t dev, int block)
   return -1;
 }
 
+/**
+ * return the sector aligned buffer of the input, for a direct read of 'len'
+ * bytes meant for an unaligned one.  It only grows, so after the first
+ * reads no more memory is allocated.  Called with the bounce lock held.
+ */
+static unsigned char *file_bounce_buffer(dvd_input_t dev, size_t len)
+{
+  unsigned char *base;
+
+  if(len <= dev->bounce_size)
+    return dev->bounce;
+
+  base = malloc(len + DVD_VIDEO_LB_LEN);
+  if(!base)
+    return NULL;
+  free(dev->bounce_base);
+  dev->bounce_base = base;
+  dev->bounce = (unsigned char *)(((uintptr_t)base
+                                   & ~((uintptr_t)DVD_VIDEO_LB_LEN - 1))
+                                  + DVD_VIDEO_LB_LEN);
+  dev->bounce_size = len;
+  return dev->bounce;
+}
+
 /**
  * read data from the device.
  */
@@ -218,12 +399,44 @@ static int file_read(dvd_input_t dev, void *buffer, int blocks, int flags)
   size_t len;
   ssize_t ret;
 
+  if(dev->map) {
+    /* Only whole blocks are returned, as read() would at the end of file. */
+    if(dev->map_pos >= dev->map_size)
+      return 0;
+    if((off_t)blocks * DVD_VIDEO_LB_LEN > dev->map_size - dev->map_pos)
+      blocks = (int) ((dev->map_size - dev->map_pos) / DVD_VIDEO_LB_LEN);
+    len = (size_t)blocks * DVD_VIDEO_LB_LEN;
+    memcpy(buffer, dev->map + dev->map_pos, len);
+    dev->map_pos += len;
+    return blocks;
+  }
+
   len = (size_t)blocks * DVD_VIDEO_LB_LEN;
 
+  /* Direct reads need a sector aligned buffer, as in file_pread(). */
+  if(dev->direct && ((uintptr_t)buffer & (DVD_VIDEO_LB_LEN - 1))) {
+    unsigned char *bounce;
+
+    pthread_mutex_lock(&dev->bounce_lock);
+    bounce = file_bounce_buffer(dev, len);
+    if(!bounce) {
+      pthread_mutex_unlock(&dev->bounce_lock);
+      return -1;
+    }
+    ret = file_read(dev, bounce, blocks, flags);
+    if(ret > 0)
+      memcpy(buffer, bounce, (size_t)ret * DVD_VIDEO_LB_LEN);
+    pthread_mutex_unlock(&dev->bounce_lock);
+    return ret;
+  }
+
   while(len > 0) {
 
     ret = read(dev->fd, buffer, len);
 
+    if(ret < 0 && errno == EINVAL && file_drop_direct(dev))
+      continue;
+
     if(ret < 0) {
       /* One of the reads failed, too bad.  We won't even bother
        * returning the reads that went OK, and as in the POSIX spec
@@ -247,6 +460,108 @@ static int file_read(dvd_input_t dev, void *buffer, int blocks, int flags)
   return blocks;
 }
 
+/**
+ * read data from a given block of the device, without using or moving the
+ * file position.
+ */
+static int file_pread(dvd_input_t dev, void *buffer, int block, int blocks,
+                      int flags)
+{
+  off_t pos = (off_t)block * (off_t)DVD_VIDEO_LB_LEN;
+  size_t len, bytes;
+  ssize_t ret;
+
+  if(dev->map) {
+    if(pos >= dev->map_size)
+      return 0;
+    if((off_t)blocks * DVD_VIDEO_LB_LEN > dev->map_size - pos)
+      blocks = (int) ((dev->map_size - pos) / DVD_VIDEO_LB_LEN);
+    memcpy(buffer, dev->map + pos, (size_t)blocks * DVD_VIDEO_LB_LEN);
+    return blocks;
+  }
+
+#ifdef WIN32
+  /* No pread() here, fall back to the shared file position. */
+  if(file_seek(dev, block) != block)
+    return -1;
+  return file_read(dev, buffer, blocks, flags);
+#else
+  len = (size_t)blocks * DVD_VIDEO_LB_LEN;
+  bytes = 0;
+
+  /* Direct reads need a sector aligned buffer, bounce the rare unaligned
+   * one (e.g. an application buffer on a cache miss) through our own. */
+  if(dev->direct && ((uintptr_t)buffer & (DVD_VIDEO_LB_LEN - 1))) {
+    unsigned char *bounce;
+
+    pthread_mutex_lock(&dev->bounce_lock);
+    bounce = file_bounce_buffer(dev, len);
+    if(!bounce) {
+      pthread_mutex_unlock(&dev->bounce_lock);
+      return -1;
+    }
+    ret = file_pread(dev, bounce, block, blocks, flags);
+    if(ret > 0)
+      memcpy(buffer, bounce, (size_t)ret * DVD_VIDEO_LB_LEN);
+    pthread_mutex_unlock(&dev->bounce_lock);
+    return ret;
+  }
+
+  while(bytes < len) {
+
+    ret = pread(dev->fd, (char *)buffer + bytes, len - bytes,
+                pos + (off_t)bytes);
+
+    if(ret < 0 && errno == EINVAL && file_drop_direct(dev))
+      continue;
+
+    if(ret < 0)
+      return ret;
+
+    /* End of file, return the whole blocks, if any. */
+    if(ret == 0)
+      break;
+
+    bytes += ret;
+  }
+
+  return (int) (bytes / DVD_VIDEO_LB_LEN);
+#endif
+}
+
+/**
+ * return a pointer into the mapping, if there is one covering the blocks.
+ */
+static const unsigned char *file_map(dvd_input_t dev, int block, int blocks)
+{
+  if(!dev->map || block < 0 || blocks < 0 ||
+     (off_t)(block + blocks) * DVD_VIDEO_LB_LEN > dev->map_size)
+    return NULL;
+  return dev->map + (off_t)block * DVD_VIDEO_LB_LEN;
+}
+
+/**
+ * ask the kernel to start paging in blocks we are going to read.
+ */
+static int file_advise(dvd_input_t dev, int block, int blocks)
+{
+#if !defined(WIN32) && defined(POSIX_MADV_WILLNEED)
+  const unsigned char *start;
+  uintptr_t page;
+
+  start = file_map(dev, block, blocks);
+  if(!start)
+    return -1;
+  /* the range has to start on a page boundary */
+  page = (uintptr_t)start & ~((uintptr_t)sysconf(_SC_PAGESIZE) - 1);
+  return posix_madvise((void *)page,
+                       (size_t)blocks * DVD_VIDEO_LB_LEN + ((uintptr_t)start - page),
+                       POSIX_MADV_WILLNEED);
+#else
+  return -1;
+#endif
+}
+
 /**
  * close the DVD device and clean up.
  */
@@ -254,11 +569,18 @@ static int file_close(dvd_input_t dev)
 {
   int ret;
 
+#ifndef WIN32
+  if(dev->map)
+    munmap(dev->map, (size_t)dev->map_size);
+#endif
+
   ret = close(dev->fd);
 
   if(ret < 0)
     return ret;
 
+  pthread_mutex_destroy(&dev->bounce_lock);
+  free(dev->bounce_base);
   free(dev);
 
   return 0;
@@ -340,23 +662,34 @@ int dvdinput_setup(void)
 
     /* libdvdcss wrapper functions */
     dvdinput_open  = css_open;
+    dvdinput_open_image = css_open;
     dvdinput_close = css_close;
     dvdinput_seek  = css_seek;
     dvdinput_title = css_title;
     dvdinput_read  = css_read;
+    dvdinput_pread = css_pread;
     dvdinput_error = css_error;
+    dvdinput_map   = css_map;
+    dvdinput_advise = css_advise;
     return 1;
 
   } else {
     fprintf(stderr, "libdvdread: Encrypted DVD support unavailable.\n");
 
+    /* Bypass the page cache, e.g. when streaming big images. */
+    use_direct_io = getenv("DVDREAD_DIRECT_IO") != NULL;
+
     /* libdvdcss replacement functions */
     dvdinput_open  = file_open;
+    dvdinput_open_image = file_open_image;
     dvdinput_close = file_close;
     dvdinput_seek  = file_seek;
     dvdinput_title = file_title;
     dvdinput_read  = file_read;
+    dvdinput_pread = file_pread;
     dvdinput_error = file_error;
+    dvdinput_map   = file_map;
+    dvdinput_advise = file_advise;
     return 0;
   }
 }
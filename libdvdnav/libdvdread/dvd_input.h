@@ -34,14 +34,41 @@ typedef struct dvd_input_s *dvd_input_t;
  * These functions provide the main API.
  */
 extern dvd_input_t (*dvdinput_open)  (const char *);
+
+/**
+ * Opens a whole disc, an image file or a device, rather than one of the
+ * files on it.  Only such an input may be memory mapped.
+ */
+extern dvd_input_t (*dvdinput_open_image) (const char *);
+
 extern int         (*dvdinput_close) (dvd_input_t);
 extern int         (*dvdinput_seek)  (dvd_input_t, int);
 extern int         (*dvdinput_title) (dvd_input_t, int);
 extern int         (*dvdinput_read)  (dvd_input_t, void *, int, int);
 extern char *      (*dvdinput_error) (dvd_input_t);
 
+/**
+ * Reads blocks starting at the given block, like a seek followed by a read
+ * but without touching the shared position, so several threads may read
+ * one input at once.  Returns the number of blocks read or a negative error.
+ */
+extern int         (*dvdinput_pread) (dvd_input_t, void *, int, int, int);
+
+/**
+ * Returns a pointer to the given blocks when the input is memory mapped,
+ * NULL otherwise.  The pointer stays valid until the input is closed.
+ */
+extern const unsigned char *(*dvdinput_map) (dvd_input_t, int, int);
+
+/**
+ * Hints that the given blocks are going to be read soon.
+ */
+extern int         (*dvdinput_advise) (dvd_input_t, int, int);
+
 /**
  * Setup function accessed by dvd_reader.c.  Returns 1 if there is CSS support.
+ * Without CSS support, setting DVDREAD_DIRECT_IO in the environment opens the
+ * inputs with O_DIRECT where the system and filesystem allow it.
  */
 int dvdinput_setup(void);
 
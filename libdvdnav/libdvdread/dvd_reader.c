@@ -31,6 +31,8 @@
 #include <unistd.h>
 #include <limits.h>
 #include <dirent.h>
+#include <pthread.h>
+#include <stddef.h>
 
 /* misc win32 helpers */
 #ifdef WIN32
@@ -66,6 +68,8 @@ static inline int _private_gettimeofday( struct timeval *tv, void *tz )
 #include "dvd_udf.h"
 #include "dvd_input.h"
 #include "dvd_reader.h"
+#include "ifo_types.h"
+#include "ifo_cache.h"
 #include "md5.h"
 
 #define DEFAULT_UDF_CACHE_LEVEL 1
@@ -88,6 +92,12 @@ struct dvd_reader_s {
     /* Filesystem cache */
     int udfcache_level; /* 0 - turned off, 1 - on */
     void *udfcache;
+
+    /* Keeps a title key switch together with the read that needs it. */
+    pthread_mutex_t css_lock;
+
+    /* IFO files of the disc, NULL if the IFO cache is off */
+    ifo_cache_t *ifo_cache;
 };
 
 #define TITLES_MAX 9
@@ -109,6 +119,14 @@ struct dvd_file_s {
 
     /* Calculated at open-time, size in blocks. */
     ssize_t filesize;
+
+    /* The whole file, for an IFO file in the IFO cache. */
+    const unsigned char *ifo_image;
+
+    /* Sector buffer of DVDReadBytes(), kept for the next call. */
+    unsigned char *scratch_base;
+    unsigned char *scratch;
+    size_t scratch_blocks;
 };
 
 int UDFReadBlocksRaw( dvd_reader_t *device, uint32_t lb_number,
@@ -228,7 +246,7 @@ static dvd_reader_t *DVDOpenImageFile( const char *location, int have_css )
     dvd_reader_t *dvd;
     dvd_input_t dev;
 
-    dev = dvdinput_open( location );
+    dev = dvdinput_open_image( location );
     if( !dev ) {
 	fprintf( stderr, "libdvdread: Can't open %s for reading\n", location );
 	return NULL;
@@ -245,6 +263,8 @@ static dvd_reader_t *DVDOpenImageFile( const char *location, int have_css )
 
     dvd->udfcache_level = DEFAULT_UDF_CACHE_LEVEL;
     dvd->udfcache = NULL;
+    pthread_mutex_init( &dvd->css_lock, NULL );
+    dvd->ifo_cache = NULL;
 
     if( have_css ) {
       /* Only if DVDCSS_METHOD = title, a bit if it's disc or if
@@ -274,6 +294,8 @@ static dvd_reader_t *DVDOpenPath( const char *path_root )
 
     dvd->udfcache_level = DEFAULT_UDF_CACHE_LEVEL;
     dvd->udfcache = NULL;
+    pthread_mutex_init( &dvd->css_lock, NULL );
+    dvd->ifo_cache = NULL;
 
     dvd->css_state = 0; /* Only used in the UDF path */
     dvd->css_title = 0; /* Only matters in the UDF path */
@@ -326,7 +348,7 @@ static char *bsd_block2char( const char *path )
 }
 #endif
 
-dvd_reader_t *DVDOpen( const char *ppath )
+static dvd_reader_t *DVDOpenReader( const char *ppath )
 {
     struct stat fileinfo;
     int ret;
@@ -549,12 +571,60 @@ dvd_reader_t *DVDOpen( const char *ppath )
     return NULL;
 }
 
+/* Directory of the IFO cache, NULL while it is off */
+/* DVDOpen() works with a copy, the lock is only held to take it. */
+static pthread_mutex_t ifo_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static char *ifo_cache_dir = NULL;
+
+static void DVDOpenIFOCache( dvd_reader_t *dvd, const char *dir );
+
+dvd_reader_t *DVDOpen( const char *ppath )
+{
+    dvd_reader_t *dvd;
+    char *dir = NULL;
+
+    dvd = DVDOpenReader( ppath );
+    if( !dvd )
+	return NULL;
+
+    pthread_mutex_lock( &ifo_cache_lock );
+    if( ifo_cache_dir )
+	dir = strdup( ifo_cache_dir );
+    pthread_mutex_unlock( &ifo_cache_lock );
+
+    if( dir ) {
+	DVDOpenIFOCache( dvd, dir );
+	free( dir );
+    }
+
+    return dvd;
+}
+
+int DVDSetIFOCache( const char *path )
+{
+    char *dir = NULL;
+
+    if( path ) {
+	dir = strdup( path );
+	if( !dir )
+	    return -1;
+    }
+
+    pthread_mutex_lock( &ifo_cache_lock );
+    free( ifo_cache_dir );
+    ifo_cache_dir = dir;
+    pthread_mutex_unlock( &ifo_cache_lock );
+    return 0;
+}
+
 void DVDClose( dvd_reader_t *dvd )
 {
     if( dvd ) {
         if( dvd->dev ) dvdinput_close( dvd->dev );
         if( dvd->path_root ) free( dvd->path_root );
 	if( dvd->udfcache ) FreeUDFCache( dvd->udfcache );
+	ifoCacheFree( dvd->ifo_cache );
+        pthread_mutex_destroy( &dvd->css_lock );
         free( dvd );
     }
 }
@@ -584,6 +654,32 @@ static dvd_file_t *DVDOpenFileUDF( dvd_reader_t *dvd, char *filename )
     memset( dvd_file->title_sizes, 0, sizeof( dvd_file->title_sizes ) );
     memset( dvd_file->title_devs, 0, sizeof( dvd_file->title_devs ) );
     dvd_file->filesize = len / DVD_VIDEO_LB_LEN;
+    dvd_file->ifo_image = NULL;
+    dvd_file->scratch_base = NULL;
+    dvd_file->scratch_blocks = 0;
+
+    return dvd_file;
+}
+
+/**
+ * Open an IFO file kept in the IFO cache, it is read from memory.
+ */
+static dvd_file_t *DVDOpenFileCached( dvd_reader_t *dvd, int titlenum )
+{
+    dvd_file_t *dvd_file;
+
+    dvd_file = (dvd_file_t *) malloc( sizeof( dvd_file_t ) );
+    if( !dvd_file ) return NULL;
+    dvd_file->dvd = dvd;
+    dvd_file->css_title = 0;
+    dvd_file->lb_start = 0;
+    dvd_file->seek_pos = 0;
+    memset( dvd_file->title_sizes, 0, sizeof( dvd_file->title_sizes ) );
+    memset( dvd_file->title_devs, 0, sizeof( dvd_file->title_devs ) );
+    dvd_file->filesize = dvd->ifo_cache->size[ titlenum ] / DVD_VIDEO_LB_LEN;
+    dvd_file->ifo_image = dvd->ifo_cache->data[ titlenum ];
+    dvd_file->scratch_base = NULL;
+    dvd_file->scratch_blocks = 0;
 
     return dvd_file;
 }
@@ -681,6 +777,9 @@ static dvd_file_t *DVDOpenFilePath( dvd_reader_t *dvd, char *filename )
     memset( dvd_file->title_sizes, 0, sizeof( dvd_file->title_sizes ) );
     memset( dvd_file->title_devs, 0, sizeof( dvd_file->title_devs ) );
     dvd_file->filesize = 0;
+    dvd_file->ifo_image = NULL;
+    dvd_file->scratch_base = NULL;
+    dvd_file->scratch_blocks = 0;
 
     if( stat( full_path, &fileinfo ) < 0 ) {
         fprintf( stderr, "libdvdread: Can't stat() %s.\n", filename );
@@ -717,6 +816,9 @@ static dvd_file_t *DVDOpenVOBUDF( dvd_reader_t *dvd, int title, int menu )
     memset( dvd_file->title_sizes, 0, sizeof( dvd_file->title_sizes ) );
     memset( dvd_file->title_devs, 0, sizeof( dvd_file->title_devs ) );
     dvd_file->filesize = len / DVD_VIDEO_LB_LEN;
+    dvd_file->ifo_image = NULL;
+    dvd_file->scratch_base = NULL;
+    dvd_file->scratch_blocks = 0;
 
     /* Calculate the complete file size for every file in the VOBS */
     if( !menu ) {
@@ -760,6 +862,9 @@ static dvd_file_t *DVDOpenVOBPath( dvd_reader_t *dvd, int title, int menu )
     memset( dvd_file->title_sizes, 0, sizeof( dvd_file->title_sizes ) );
     memset( dvd_file->title_devs, 0, sizeof( dvd_file->title_devs ) );
     dvd_file->filesize = 0;
+    dvd_file->ifo_image = NULL;
+    dvd_file->scratch_base = NULL;
+    dvd_file->scratch_blocks = 0;
 
     if( menu ) {
         dvd_input_t dev;
@@ -829,6 +934,9 @@ dvd_file_t *DVDOpenFile( dvd_reader_t *dvd, int titlenum,
 
     switch( domain ) {
     case DVD_READ_INFO_FILE:
+        if( dvd->ifo_cache && titlenum < dvd->ifo_cache->nr_of_files ) {
+            return DVDOpenFileCached( dvd, titlenum );
+        }
         if( titlenum == 0 ) {
             sprintf( filename, "/VIDEO_TS/VIDEO_TS.IFO" );
         } else {
@@ -884,6 +992,7 @@ void DVDCloseFile( dvd_file_t *dvd_file )
             }
         }
 
+        free( dvd_file->scratch_base );
         free( dvd_file );
         dvd_file = 0;
     }
@@ -895,19 +1004,16 @@ int UDFReadBlocksRaw( dvd_reader_t *device, uint32_t lb_number,
 			 int encrypted )
 {
    int ret;
+
    if( !device->dev ) {
      	fprintf( stderr, "libdvdread: Fatal error in block read.\n" );
 	return 0;
    }
 
-   ret = dvdinput_seek( device->dev, (int) lb_number );
-   if( ret != (int) lb_number ) {
-     	fprintf( stderr, "libdvdread: Can't seek to block %u\n", lb_number );
-	return 0;
-   }
-
-   ret = dvdinput_read( device->dev, (char *) data,
+   ret = dvdinput_pread( device->dev, (char *) data, (int) lb_number,
 			 (int) block_count, encrypted );
+   if( ret < 0 )
+     	fprintf( stderr, "libdvdread: Can't read block %u\n", lb_number );
    return ret;
 }
 
@@ -930,73 +1036,46 @@ static int DVDReadBlocksUDF( dvd_file_t *dvd_file, uint32_t offset,
  * Reads 'block_count' blocks from 'dvd_file' at block offset 'offset'
  * into the buffer located at 'data' and if 'encrypted' is set
  * descramble the data if it's encrypted.  Returning either an
- * negative error or the number of blocks read. */
+ * negative error or the number of blocks read.
+ *
+ * The range may cover any number of title parts, each part gets a single
+ * positional read for its share of the range. */
 static int DVDReadBlocksPath( dvd_file_t *dvd_file, unsigned int offset,
 			      size_t block_count, unsigned char *data,
 			      int encrypted )
 {
     int i;
-    int ret, ret2, off;
-
-    ret = 0;
-    ret2 = 0;
-    for( i = 0; i < TITLES_MAX; ++i ) {
-      if( !dvd_file->title_sizes[ i ] ) return 0; /* Past end of file */
-
-        if( offset < dvd_file->title_sizes[ i ] ) {
-            if( ( offset + block_count ) <= dvd_file->title_sizes[ i ] ) {
-		off = dvdinput_seek( dvd_file->title_devs[ i ], (int)offset );
-                if( off < 0 || off != (int)offset ) {
-		    fprintf( stderr, "libdvdread: Can't seek to block %d\n",
-			     offset );
-		    return off < 0 ? off : 0;
-		}
-                ret = dvdinput_read( dvd_file->title_devs[ i ], data,
-				     (int)block_count, encrypted );
-                break;
-            } else {
-                size_t part1_size = dvd_file->title_sizes[ i ] - offset;
-		/* FIXME: Really needs to be a while loop.
-                 * (This is only true if you try and read >1GB at a time) */
-
-                /* Read part 1 */
-                off = dvdinput_seek( dvd_file->title_devs[ i ], (int)offset );
-                if( off < 0 || off != (int)offset ) {
-		    fprintf( stderr, "libdvdread: Can't seek to block %d\n",
-			     offset );
-		    return off < 0 ? off : 0;
-		}
-                ret = dvdinput_read( dvd_file->title_devs[ i ], data,
-				     (int)part1_size, encrypted );
-		if( ret < 0 ) return ret;
-		/* FIXME: This is wrong if i is the last file in the set.
-                 * also error from this read will not show in ret. */
-
-		/* Does the next part exist? If not then return now. */
-		if( i + 1 >= TITLES_MAX || !dvd_file->title_devs[ i + 1 ] )
-                    return ret;
-
-                /* Read part 2 */
-                off = dvdinput_seek( dvd_file->title_devs[ i + 1 ], 0 );
-                if( off < 0 || off != 0 ) {
-		    fprintf( stderr, "libdvdread: Can't seek to block %d\n",
-			     0 );
-		    return off < 0 ? off : 0;
-		}
-                ret2 = dvdinput_read( dvd_file->title_devs[ i + 1 ],
-				      data + ( part1_size
-					       * (int64_t)DVD_VIDEO_LB_LEN ),
-				      (int)(block_count - part1_size),
-				      encrypted );
-                if( ret2 < 0 ) return ret2;
-		break;
-            }
-        } else {
+    int ret;
+    size_t done, part;
+
+    done = 0;
+    for( i = 0; i < TITLES_MAX && done < block_count; ++i ) {
+        if( !dvd_file->title_sizes[ i ] || !dvd_file->title_devs[ i ] )
+	    break; /* Past end of file */
+
+        if( offset >= dvd_file->title_sizes[ i ] ) {
             offset -= dvd_file->title_sizes[ i ];
-        }
+	    continue;
+	}
+
+	part = dvd_file->title_sizes[ i ] - offset;
+	if( part > block_count - done ) part = block_count - done;
+
+	ret = dvdinput_pread( dvd_file->title_devs[ i ],
+			      data + done * (int64_t)DVD_VIDEO_LB_LEN,
+			      (int)offset, (int)part, encrypted );
+	if( ret < 0 ) {
+	    /* Report the blocks we did get before the error. */
+	    return done ? (int)done : ret;
+	}
+	done += ret;
+	if( (size_t)ret < part ) break; /* Part shorter than its size said */
+
+	/* Following parts are read from their start. */
+	offset = 0;
     }
 
-    return ret + ret2;
+    return (int)done;
 }
 
 /* This is broken reading more than 2Gb at a time is ssize_t is 32-bit. */
@@ -1008,22 +1087,33 @@ ssize_t DVDReadBlocks( dvd_file_t *dvd_file, int offset,
     if( dvd_file == NULL || offset < 0 || data == NULL )
       return -1;
 
-    /* Hack, and it will still fail for multiple opens in a threaded app ! */
-    if( dvd_file->dvd->css_title != dvd_file->css_title ) {
-      dvd_file->dvd->css_title = dvd_file->css_title;
-      if( dvd_file->dvd->isImageFile ) {
-	dvdinput_title( dvd_file->dvd->dev, (int)dvd_file->lb_start );
-      }
-      /* Here each vobu has it's own dvdcss handle, so no need to update
-      else {
-	dvdinput_title( dvd_file->title_devs[ 0 ], (int)dvd_file->lb_start );
-      }*/
+    if( dvd_file->ifo_image ) {
+	if( (ssize_t)offset >= dvd_file->filesize )
+	    return 0;
+	if( (ssize_t)( offset + block_count ) > dvd_file->filesize )
+	    block_count = dvd_file->filesize - offset;
+	memcpy( data, dvd_file->ifo_image + offset * (size_t)DVD_VIDEO_LB_LEN,
+		block_count * DVD_VIDEO_LB_LEN );
+	return (ssize_t)block_count;
     }
 
-    if( dvd_file->dvd->isImageFile ) {
+    if( dvd_file->dvd->isImageFile && dvd_file->dvd->css_state ) {
+	/* libdvdcss keeps one title key per handle, so switching the key
+	 * and reading with it has to happen under one lock. */
+	pthread_mutex_lock( &dvd_file->dvd->css_lock );
+	if( dvd_file->dvd->css_title != dvd_file->css_title ) {
+	    dvd_file->dvd->css_title = dvd_file->css_title;
+	    dvdinput_title( dvd_file->dvd->dev, (int)dvd_file->lb_start );
+	}
+	ret = DVDReadBlocksUDF( dvd_file, (uint32_t)offset,
+				block_count, data, DVDINPUT_READ_DECRYPT );
+	pthread_mutex_unlock( &dvd_file->dvd->css_lock );
+    } else if( dvd_file->dvd->isImageFile ) {
 	ret = DVDReadBlocksUDF( dvd_file, (uint32_t)offset,
 				block_count, data, DVDINPUT_READ_DECRYPT );
     } else {
+	/* Here each vob has its own dvdcss handle, so there is no title
+	 * key to switch. */
 	ret = DVDReadBlocksPath( dvd_file, (unsigned int)offset,
 				 block_count, data, DVDINPUT_READ_DECRYPT );
     }
@@ -1031,6 +1121,63 @@ ssize_t DVDReadBlocks( dvd_file_t *dvd_file, int offset,
     return (ssize_t)ret;
 }
 
+const unsigned char *DVDMapBlocks( dvd_file_t *dvd_file, int offset,
+				   size_t block_count )
+{
+    /* Check arguments. */
+    if( dvd_file == NULL || offset < 0 )
+	return NULL;
+
+    if( dvd_file->ifo_image ) {
+	if( (ssize_t)( offset + block_count ) > dvd_file->filesize )
+	    return NULL;
+	return dvd_file->ifo_image + offset * (size_t)DVD_VIDEO_LB_LEN;
+    }
+
+    /* Only the image stays mapped for as long as the reader is open. */
+    if( !dvd_file->dvd->isImageFile
+	|| (ssize_t)( offset + block_count ) > dvd_file->filesize )
+	return NULL;
+
+    return dvdinput_map( dvd_file->dvd->dev,
+			 (int)( dvd_file->lb_start + offset ), (int)block_count );
+}
+
+void DVDAdviseBlocks( dvd_file_t *dvd_file, int offset, size_t block_count )
+{
+    int i;
+
+    /* Check arguments. */
+    if( dvd_file == NULL || offset < 0 || dvd_file->ifo_image )
+	return;
+
+    if( dvd_file->dvd->isImageFile ) {
+	if( (ssize_t)offset >= dvd_file->filesize )
+	    return;
+	if( (ssize_t)( offset + block_count ) > dvd_file->filesize )
+	    block_count = dvd_file->filesize - offset;
+	dvdinput_advise( dvd_file->dvd->dev,
+			 (int)( dvd_file->lb_start + offset ), (int)block_count );
+	return;
+    }
+
+    /* Split the range over the title parts. */
+    for( i = 0; i < TITLES_MAX && block_count > 0; ++i ) {
+	size_t part;
+
+	if( !dvd_file->title_devs[ i ] ) return;
+	if( (size_t)offset >= dvd_file->title_sizes[ i ] ) {
+	    offset -= dvd_file->title_sizes[ i ];
+	    continue;
+	}
+	part = dvd_file->title_sizes[ i ] - offset;
+	if( part > block_count ) part = block_count;
+	dvdinput_advise( dvd_file->title_devs[ i ], offset, (int)part );
+	block_count -= part;
+	offset = 0;
+    }
+}
+
 int32_t DVDFileSeek( dvd_file_t *dvd_file, int32_t offset )
 {
     /* Check arguments. */
@@ -1050,7 +1197,7 @@ int DVDFileSeekForce(dvd_file_t *dvd_file, int offset, int force_size)
     if( dvd_file == NULL || offset <= 0 )
         return -1;
 
-    if( dvd_file->dvd->isImageFile ) {
+    if( dvd_file->dvd->isImageFile && !dvd_file->ifo_image ) {
         if( force_size < 0 )
             force_size = (offset - 1) / DVD_VIDEO_LB_LEN + 1;
         if( dvd_file->filesize < force_size ) {
@@ -1066,9 +1213,34 @@ int DVDFileSeekForce(dvd_file_t *dvd_file, int offset, int force_size)
     return offset;
 }
 
+/* Returns the sector buffer of the file, grown to hold 'blocks' blocks. It
+ * is aligned for direct reads. */
+static unsigned char *DVDFileScratch( dvd_file_t *dvd_file, size_t blocks )
+{
+    unsigned char *base;
+
+    if( blocks <= dvd_file->scratch_blocks )
+	return dvd_file->scratch;
+
+    /* Most reads are short, grow in steps to keep reallocations rare. */
+    if( blocks < 2 * dvd_file->scratch_blocks )
+	blocks = 2 * dvd_file->scratch_blocks;
+
+    base = (unsigned char *) malloc( blocks * DVD_VIDEO_LB_LEN + 2048 );
+    if( !base )
+	return NULL;
+
+    free( dvd_file->scratch_base );
+    dvd_file->scratch_base = base;
+    dvd_file->scratch = (unsigned char *)(((uintptr_t)base & ~((uintptr_t)2047)) + 2048);
+    dvd_file->scratch_blocks = blocks;
+
+    return dvd_file->scratch;
+}
+
 ssize_t DVDReadBytes( dvd_file_t *dvd_file, void *data, size_t byte_size )
 {
-    unsigned char *secbuf_base, *secbuf;
+    unsigned char *secbuf;
     unsigned int numsec, seek_sector, seek_byte;
     int ret;
 
@@ -1076,18 +1248,33 @@ ssize_t DVDReadBytes( dvd_file_t *dvd_file, void *data, size_t byte_size )
     if( dvd_file == NULL || data == NULL )
       return -1;
 
+    if( dvd_file->ifo_image ) {
+	/* Straight out of the IFO cache. */
+	if( (uint64_t)dvd_file->seek_pos + byte_size
+	    > (uint64_t)dvd_file->filesize * DVD_VIDEO_LB_LEN )
+	    return 0;
+	memcpy( data, dvd_file->ifo_image + dvd_file->seek_pos, byte_size );
+	dvd_file->seek_pos += byte_size;
+	return byte_size;
+    }
+
     seek_sector = dvd_file->seek_pos / DVD_VIDEO_LB_LEN;
     seek_byte   = dvd_file->seek_pos % DVD_VIDEO_LB_LEN;
 
     numsec = ( ( seek_byte + byte_size ) / DVD_VIDEO_LB_LEN ) +
       ( ( ( seek_byte + byte_size ) % DVD_VIDEO_LB_LEN ) ? 1 : 0 );
 
-    secbuf_base = (unsigned char *) malloc( numsec * DVD_VIDEO_LB_LEN + 2048 );
-    secbuf = (unsigned char *)(((uintptr_t)secbuf_base & ~((uintptr_t)2047)) + 2048);
-    if( !secbuf_base ) {
-	fprintf( stderr, "libdvdread: Can't allocate memory "
-		 "for file read!\n" );
-        return 0;
+    if( seek_byte == 0 && byte_size % DVD_VIDEO_LB_LEN == 0
+	&& !((uintptr_t)data & 2047) ) {
+	/* Whole blocks go straight into the caller's buffer. */
+	secbuf = data;
+    } else {
+	secbuf = DVDFileScratch( dvd_file, numsec );
+	if( !secbuf ) {
+	    fprintf( stderr, "libdvdread: Can't allocate memory "
+		     "for file read!\n" );
+	    return 0;
+	}
     }
 
     if( dvd_file->dvd->isImageFile ) {
@@ -1099,12 +1286,11 @@ ssize_t DVDReadBytes( dvd_file_t *dvd_file, void *data, size_t byte_size )
     }
 
     if( ret != (int) numsec ) {
-        free( secbuf_base );
         return ret < 0 ? ret : 0;
     }
 
-    memcpy( data, &(secbuf[ seek_byte ]), byte_size );
-    free( secbuf_base );
+    if( secbuf != data )
+	memcpy( data, &(secbuf[ seek_byte ]), byte_size );
 
     DVDFileSeekForce(dvd_file, dvd_file->seek_pos + byte_size, -1);
     return byte_size;
@@ -1119,9 +1305,14 @@ ssize_t DVDFileSize( dvd_file_t *dvd_file )
     return dvd_file->filesize;
 }
 
+/* DVDDiscID() reads the IFO files in pieces of this many blocks, through
+ * a single buffer. */
+#define DISCID_READ_BLOCKS 32
+
 int DVDDiscID( dvd_reader_t *dvd, unsigned char *discid )
 {
     struct md5_ctx ctx;
+    unsigned char *buffer_base, *buffer;
     int title;
     int nr_of_files = 0;
 
@@ -1129,40 +1320,55 @@ int DVDDiscID( dvd_reader_t *dvd, unsigned char *discid )
     if( dvd == NULL || discid == NULL )
       return 0;
 
+    /* The IFO cache worked it out already. */
+    if( dvd->ifo_cache ) {
+	memcpy( discid, dvd->ifo_cache->discid, 16 );
+	return 0;
+    }
+
+    /* Aligned, the whole block reads go straight into it. */
+    buffer_base = malloc( DISCID_READ_BLOCKS * DVD_VIDEO_LB_LEN + 2048 );
+    if( buffer_base == NULL ) {
+	fprintf( stderr, "libdvdread: DVDDiscId, failed to "
+		 "allocate memory for file read!\n" );
+	return -1;
+    }
+    buffer = (unsigned char *)(((uintptr_t)buffer_base & ~((uintptr_t)2047)) + 2048);
+
     /* Go through the first 10 IFO:s, in order,
      * and md5sum them, i.e  VIDEO_TS.IFO and VTS_0?_0.IFO */
     md5_init_ctx( &ctx );
     for( title = 0; title < 10; title++ ) {
 	dvd_file_t *dvd_file = DVDOpenFile( dvd, title, DVD_READ_INFO_FILE );
 	if( dvd_file != NULL ) {
-	    ssize_t bytes_read;
-	    size_t file_size = dvd_file->filesize * DVD_VIDEO_LB_LEN;
-	    char *buffer_base = malloc( file_size + 2048 );
-	    char *buffer = (char *)(((uintptr_t)buffer_base & ~((uintptr_t)2047)) + 2048);
-
-	    if( buffer_base == NULL ) {
-	        DVDCloseFile( dvd_file );
-		fprintf( stderr, "libdvdread: DVDDiscId, failed to "
-			 "allocate memory for file read!\n" );
-		return -1;
-	    }
-	    bytes_read = DVDReadBytes( dvd_file, buffer, file_size );
-	    if( bytes_read != file_size ) {
-		fprintf( stderr, "libdvdread: DVDDiscId read returned %zd bytes"
-			 ", wanted %zd\n", bytes_read, file_size );
-		DVDCloseFile( dvd_file );
-		free( buffer_base );
-		return -1;
-	    }
+	    ssize_t blocks_left = dvd_file->filesize;
+
+	    while( blocks_left > 0 ) {
+		size_t read_size = DISCID_READ_BLOCKS * DVD_VIDEO_LB_LEN;
+		ssize_t bytes_read;
+
+		if( blocks_left < DISCID_READ_BLOCKS )
+		    read_size = blocks_left * DVD_VIDEO_LB_LEN;
+
+		bytes_read = DVDReadBytes( dvd_file, buffer, read_size );
+		if( bytes_read != (ssize_t)read_size ) {
+		    fprintf( stderr, "libdvdread: DVDDiscId read returned %zd "
+			     "bytes, wanted %zd\n", bytes_read, read_size );
+		    DVDCloseFile( dvd_file );
+		    free( buffer_base );
+		    return -1;
+		}
 
-	    md5_process_bytes( buffer, file_size,  &ctx );
+		md5_process_bytes( buffer, read_size, &ctx );
+		blocks_left -= read_size / DVD_VIDEO_LB_LEN;
+	    }
 
 	    DVDCloseFile( dvd_file );
-	    free( buffer_base );
 	    nr_of_files++;
 	}
     }
     md5_finish_ctx( &ctx, discid );
+    free( buffer_base );
     if(!nr_of_files)
       return -1;
 
@@ -1170,6 +1376,186 @@ int DVDDiscID( dvd_reader_t *dvd, unsigned char *discid )
 }
 
 
+/* Reads the header field 'offset' of an IFO file, big endian. */
+static uint32_t DVDIFOField( const unsigned char *data, size_t offset,
+			     size_t size )
+{
+    uint32_t value = 0;
+
+    while( size-- )
+	value = ( value << 8 ) | data[ offset++ ];
+    return value;
+}
+
+/**
+ * Reads the first block of an IFO file, its header.  Returns 1 on success,
+ * 0 on error.
+ */
+static int DVDReadIFOHeader( dvd_reader_t *dvd, int title,
+			     unsigned char *block )
+{
+    dvd_file_t *dvd_file;
+    ssize_t bytes_read;
+
+    dvd_file = DVDOpenFile( dvd, title, DVD_READ_INFO_FILE );
+    if( dvd_file == NULL )
+	return 0;
+    bytes_read = DVDReadBytes( dvd_file, block, DVD_VIDEO_LB_LEN );
+    DVDCloseFile( dvd_file );
+    return bytes_read == DVD_VIDEO_LB_LEN;
+}
+
+/**
+ * Works out the probe of the disc, see ifo_cache.h, and the sizes of its
+ * IFO files.  Only the first block of VIDEO_TS.IFO is read, into 'block'.
+ * Returns the number of IFO files, 0 on error.
+ */
+static int DVDProbeIFOFiles( dvd_reader_t *dvd, unsigned char *probe,
+			     uint32_t *sizes, unsigned char *block )
+{
+    unsigned char size[ 4 ];
+    struct md5_ctx ctx;
+    dvd_file_t *dvd_file;
+    int nr_of_files, title;
+
+    if( !DVDReadIFOHeader( dvd, 0, block ) )
+	return 0;
+
+    nr_of_files = 1 + DVDIFOField( block,
+		offsetof( vmgi_mat_t, vmg_nr_of_title_sets ), 2 );
+    if( nr_of_files > IFO_CACHE_MAX_FILES )
+	return 0;
+
+    /* The header of VIDEO_TS.IFO tells most discs apart, the sizes of the
+     * IFO files the rest. */
+    md5_init_ctx( &ctx );
+    md5_process_bytes( block, DVD_VIDEO_LB_LEN, &ctx );
+    for( title = 0; title < nr_of_files; title++ ) {
+	dvd_file = DVDOpenFile( dvd, title, DVD_READ_INFO_FILE );
+	if( dvd_file == NULL )
+	    return 0;
+	sizes[ title ] = dvd_file->filesize * DVD_VIDEO_LB_LEN;
+	DVDCloseFile( dvd_file );
+
+	size[ 0 ] = sizes[ title ] >> 24;
+	size[ 1 ] = sizes[ title ] >> 16;
+	size[ 2 ] = sizes[ title ] >> 8;
+	size[ 3 ] = sizes[ title ];
+	md5_process_bytes( size, sizeof( size ), &ctx );
+    }
+    md5_finish_ctx( &ctx, probe );
+
+    return nr_of_files;
+}
+
+/**
+ * Reads a whole IFO file in.  Fails for a file shorter than its header
+ * says, the IFO parser would read past its end.
+ */
+static int DVDReadIFOFile( dvd_reader_t *dvd, int title,
+			   unsigned char *data, uint32_t size )
+{
+    dvd_file_t *dvd_file;
+    uint32_t last_sector;
+    ssize_t bytes_read;
+
+    if( size < DVD_VIDEO_LB_LEN )
+	return 0;
+
+    dvd_file = DVDOpenFile( dvd, title, DVD_READ_INFO_FILE );
+    if( dvd_file == NULL )
+	return 0;
+    bytes_read = DVDReadBytes( dvd_file, data, size );
+    DVDCloseFile( dvd_file );
+    if( bytes_read != (ssize_t)size )
+	return 0;
+
+    if( title == 0 ) {
+	last_sector = DVDIFOField( data,
+		offsetof( vmgi_mat_t, vmgi_last_sector ), 4 );
+    } else {
+	last_sector = DVDIFOField( data,
+		offsetof( vtsi_mat_t, vtsi_last_sector ), 4 );
+    }
+    return last_sector < size / DVD_VIDEO_LB_LEN;
+}
+
+/**
+ * Checks a cache found by its probe against the disc, two discs may share
+ * a probe.  The cached VIDEO_TS.IFO has to start with the block the probe
+ * was made from, and the first VTS IFO with the header read from the disc.
+ */
+static int DVDCheckIFOCache( dvd_reader_t *dvd, const ifo_cache_t *cache,
+			     const unsigned char *block, int nr_of_files )
+{
+    unsigned char header[ DVD_VIDEO_LB_LEN ];
+
+    if( cache->nr_of_files != nr_of_files
+	|| cache->size[ 0 ] < DVD_VIDEO_LB_LEN
+	|| memcmp( cache->data[ 0 ], block, DVD_VIDEO_LB_LEN ) )
+	return 0;
+    if( nr_of_files < 2 )
+	return 1;
+    if( cache->size[ 1 ] < DVD_VIDEO_LB_LEN )
+	return 0;
+
+    if( !DVDReadIFOHeader( dvd, 1, header ) )
+	return 0;
+    return !memcmp( cache->data[ 1 ], header, DVD_VIDEO_LB_LEN );
+}
+
+/**
+ * Sets up the IFO cache of a newly opened disc.  A disc that is not in the
+ * cache yet, or whose cache entry doesn't match it, has all its IFO files
+ * read in and written to the cache.
+ */
+static void DVDOpenIFOCache( dvd_reader_t *dvd, const char *dir )
+{
+    uint32_t sizes[ IFO_CACHE_MAX_FILES ];
+    unsigned char block[ DVD_VIDEO_LB_LEN ];
+    unsigned char probe[ 16 ];
+    ifo_cache_t *cache;
+    int nr_of_files, title;
+
+    nr_of_files = DVDProbeIFOFiles( dvd, probe, sizes, block );
+    if( !nr_of_files )
+	return;
+
+    cache = ifoCacheLoad( dir, probe );
+    if( cache ) {
+	if( DVDCheckIFOCache( dvd, cache, block, nr_of_files ) ) {
+	    dvd->ifo_cache = cache;
+	    return;
+	}
+	fprintf( stderr, "libdvdread: The cached IFO files are of another "
+		 "disc, reading them again.\n" );
+	ifoCacheFree( cache );
+    }
+
+    cache = ifoCacheNew( sizes, nr_of_files );
+    if( !cache )
+	return;
+    memcpy( cache->probe, probe, sizeof( probe ) );
+
+    for( title = 0; title < nr_of_files; title++ ) {
+	if( !DVDReadIFOFile( dvd, title, cache->data[ title ],
+			     cache->size[ title ] ) ) {
+	    fprintf( stderr, "libdvdread: Not caching the IFO files, "
+		     "IFO %d can't be read whole.\n", title );
+	    ifoCacheFree( cache );
+	    return;
+	}
+    }
+    ifoCacheSetID( cache );
+
+    if( ifoCacheStore( dir, cache ) < 0 )
+	fprintf( stderr, "libdvdread: Can't write the IFO cache to %s\n",
+		 dir );
+
+    dvd->ifo_cache = cache;
+}
+
+
 int DVDISOVolumeInfo( dvd_reader_t *dvd,
 		      char *volid, unsigned int volid_size,
 		      unsigned char *volsetid, unsigned int volsetid_size )
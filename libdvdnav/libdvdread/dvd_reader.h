@@ -102,6 +102,25 @@ dvd_reader_t *DVDOpen( const char * );
  */
 void DVDClose( dvd_reader_t * );
 
+/**
+ * Keeps the IFO files of the discs opened from now on in a cache directory.
+ *
+ * DVDOpen() looks a disc up in the cache, from the first block of
+ * VIDEO_TS.IFO and the sizes of the IFO files.  A disc found there has its
+ * IFO files read from memory instead of the disc, one that isn't has them
+ * all read in once and written to the cache, named after its DVDDiscID().
+ *
+ * May be called at any time, a DVDOpen() running meanwhile uses either
+ * the old or the new directory.
+ *
+ * @param path The cache directory, created if it is missing.  NULL turns
+ *             the cache off, the default.
+ * @return 0 on success, -1 on error.
+ *
+ * DVDSetIFOCache(path);
+ */
+int DVDSetIFOCache( const char * );
+
 /**
  *
  */
@@ -155,6 +174,34 @@ void DVDCloseFile( dvd_file_t * );
  */
 ssize_t DVDReadBlocks( dvd_file_t *, int, size_t, unsigned char * );
 
+/**
+ * Returns a pointer to block_count blocks of the file at the given block
+ * offset when the image is memory mapped, so that they can be used without
+ * being read or copied.  Returns NULL if the blocks are not mapped, in which
+ * case DVDReadBlocks() has to be used.  The blocks stay valid until the
+ * reader is closed with DVDClose().  Blocks are never mapped when they might
+ * need decrypting.
+ *
+ * @param dvd_file  A file read handle.
+ * @param offset Block offset from the start of the file.
+ * @param block_count Number of blocks wanted.
+ * @return Pointer to the blocks, NULL if they are not mapped.
+ *
+ * data = DVDMapBlocks(dvd_file, offset, block_count);
+ */
+const unsigned char *DVDMapBlocks( dvd_file_t *, int, size_t );
+
+/**
+ * Hints that block_count blocks of the file at the given block offset are
+ * going to be read soon, so that a memory mapped input can page them in
+ * ahead of time.  Does nothing for inputs that are not mapped.
+ *
+ * @param dvd_file  A file read handle.
+ * @param offset Block offset from the start of the file.
+ * @param block_count Number of blocks that will be read.
+ */
+void DVDAdviseBlocks( dvd_file_t *, int, size_t );
+
 /**
  * Seek to the given position in the file.  Returns the resulting position in
  * bytes from the beginning of the file.  The seek position is only used for
@@ -201,6 +248,9 @@ ssize_t DVDFileSize( dvd_file_t * );
  * hexadecimal number, using lowercase letters, discid[0] first.
  * I.e. the same format as the command-line 'md5sum' program uses.
  *
+ * With the IFO cache on, see DVDSetIFOCache(), a disc found in the cache
+ * gets the ID stored there, it is not worked out from the disc again.
+ *
  * @param dvd A read handle to get the disc ID from
  * @param discid The buffer to put the disc ID into. The buffer must
  *               have room for 128 bits (16 chars).
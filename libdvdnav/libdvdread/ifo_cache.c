@@ -0,0 +1,343 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "config.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <inttypes.h>
+
+#include "ifo_cache.h"
+#include "md5.h"
+
+#ifndef DVD_BLOCK_LEN
+#define DVD_BLOCK_LEN 2048
+#endif
+
+/* Layout of a cache file, all numbers big endian:
+ *
+ *   "DVDIFO"         magic
+ *   uint16_t         version
+ *   discid[16]
+ *   probe[16]
+ *   uint32_t         number of files
+ *   uint32_t         size of each file, in bytes
+ *   the files, one after the other
+ *   md5[16]          MD5 sum of everything before it
+ *
+ * A probe file holds the disc ID, followed by its MD5 sum as well.
+ */
+#define IFO_CACHE_MAGIC        "DVDIFO"
+#define IFO_CACHE_HEADER_SIZE  (6 + 2 + 16 + 16 + 4)
+
+#define IFO_CACHE_SUFFIX       ".ifo"
+#define IFO_CACHE_PROBE_SUFFIX ".id"
+
+
+static void put32(unsigned char *p, uint32_t value) {
+  p[0] = value >> 24;
+  p[1] = value >> 16;
+  p[2] = value >> 8;
+  p[3] = value;
+}
+
+static uint32_t get32(const unsigned char *p) {
+  return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16)
+    | ((uint32_t)p[2] << 8) | p[3];
+}
+
+/* Returns dir/<id as hex><suffix>, to be freed by the caller. */
+static char *ifoCache_path(const char *dir, const unsigned char *id,
+                           const char *suffix) {
+  char *path;
+  size_t len;
+  int i;
+
+  len = strlen(dir);
+  path = malloc(len + 1 + 32 + strlen(suffix) + 1);
+  if(!path)
+    return NULL;
+
+  strcpy(path, dir);
+  path[len++] = '/';
+  for(i = 0; i < 16; i++)
+    sprintf(&path[len + i * 2], "%02x", id[i]);
+  strcat(path, suffix);
+
+  return path;
+}
+
+/* Reads a whole file in, NULL if it can't be read. */
+static unsigned char *ifoCache_read_file(const char *path, size_t *size) {
+  struct stat fileinfo;
+  unsigned char *data;
+  FILE *file;
+
+  file = fopen(path, "rb");
+  if(!file)
+    return NULL;
+
+  if(fstat(fileno(file), &fileinfo) < 0 || fileinfo.st_size <= 0) {
+    fclose(file);
+    return NULL;
+  }
+
+  *size = (size_t)fileinfo.st_size;
+  data = malloc(*size);
+  if(data && fread(data, 1, *size, file) != *size) {
+    free(data);
+    data = NULL;
+  }
+
+  fclose(file);
+  return data;
+}
+
+/* Writes the file under a temporary name first, so a reader never finds
+ * it half written. */
+static int ifoCache_write_file(const char *path,
+                               const unsigned char **parts,
+                               const size_t *sizes, int nr_of_parts) {
+  struct md5_ctx ctx;
+  unsigned char sum[16];
+  char *temp;
+  FILE *file;
+  int i, ok;
+
+  temp = malloc(strlen(path) + 16);
+  if(!temp)
+    return -1;
+  sprintf(temp, "%s.%d", path, (int)getpid());
+
+  file = fopen(temp, "wb");
+  if(!file) {
+    free(temp);
+    return -1;
+  }
+
+  md5_init_ctx(&ctx);
+  ok = 1;
+  for(i = 0; i < nr_of_parts && ok; i++) {
+    md5_process_bytes(parts[i], sizes[i], &ctx);
+    ok = fwrite(parts[i], 1, sizes[i], file) == sizes[i];
+  }
+  md5_finish_ctx(&ctx, sum);
+
+  if(ok)
+    ok = fwrite(sum, 1, sizeof(sum), file) == sizeof(sum);
+  if(fclose(file) != 0)
+    ok = 0;
+  if(ok)
+    ok = rename(temp, path) == 0;
+  if(!ok)
+    unlink(temp);
+
+  free(temp);
+  return ok ? 0 : -1;
+}
+
+/* Checks the MD5 sum at the end of a file read by ifoCache_read_file(). */
+static int ifoCache_check_sum(const unsigned char *data, size_t size) {
+  unsigned char sum[16];
+
+  if(size < sizeof(sum))
+    return 0;
+
+  md5_buffer((const char *)data, size - sizeof(sum), sum);
+  return !memcmp(sum, &data[size - sizeof(sum)], sizeof(sum));
+}
+
+
+ifo_cache_t *ifoCacheNew(const uint32_t *sizes, int nr_of_files) {
+  ifo_cache_t *cache;
+  size_t total;
+  int i;
+
+  if(nr_of_files <= 0 || nr_of_files > IFO_CACHE_MAX_FILES)
+    return NULL;
+
+  total = 0;
+  for(i = 0; i < nr_of_files; i++)
+    total += sizes[i];
+
+  cache = malloc(sizeof(ifo_cache_t));
+  if(!cache)
+    return NULL;
+  memset(cache, 0, sizeof(ifo_cache_t));
+
+  cache->buffer = malloc(total ? total : 1);
+  if(!cache->buffer) {
+    free(cache);
+    return NULL;
+  }
+
+  total = 0;
+  cache->nr_of_files = nr_of_files;
+  for(i = 0; i < nr_of_files; i++) {
+    cache->data[i] = &cache->buffer[total];
+    cache->size[i] = sizes[i];
+    total += sizes[i];
+  }
+
+  return cache;
+}
+
+void ifoCacheSetID(ifo_cache_t *cache) {
+  struct md5_ctx ctx;
+  int i;
+
+  /* Same as DVDDiscID(): VIDEO_TS.IFO and VTS_0?_0.IFO in order. */
+  md5_init_ctx(&ctx);
+  for(i = 0; i < cache->nr_of_files && i < 10; i++)
+    md5_process_bytes(cache->data[i], cache->size[i], &ctx);
+  md5_finish_ctx(&ctx, cache->discid);
+}
+
+ifo_cache_t *ifoCacheLoad(const char *dir, const unsigned char *probe) {
+  unsigned char discid[16];
+  unsigned char *data, *p;
+  ifo_cache_t *cache;
+  size_t size, total;
+  char *path;
+  int nr_of_files, i;
+
+  /* The probe file leads to the disc ID. */
+  path = ifoCache_path(dir, probe, IFO_CACHE_PROBE_SUFFIX);
+  if(!path)
+    return NULL;
+  data = ifoCache_read_file(path, &size);
+  free(path);
+  if(!data)
+    return NULL;
+  if(size != sizeof(discid) + 16 || !ifoCache_check_sum(data, size)) {
+    free(data);
+    return NULL;
+  }
+  memcpy(discid, data, sizeof(discid));
+  free(data);
+
+  path = ifoCache_path(dir, discid, IFO_CACHE_SUFFIX);
+  if(!path)
+    return NULL;
+  data = ifoCache_read_file(path, &size);
+  free(path);
+  if(!data)
+    return NULL;
+
+  if(size < IFO_CACHE_HEADER_SIZE + 16
+     || memcmp(data, IFO_CACHE_MAGIC, 6)
+     || ((data[6] << 8) | data[7]) != IFO_CACHE_VERSION
+     || memcmp(&data[8], discid, 16)
+     || memcmp(&data[24], probe, 16))
+    goto fail;
+
+  nr_of_files = (int)get32(&data[40]);
+  if(nr_of_files <= 0 || nr_of_files > IFO_CACHE_MAX_FILES
+     || size < IFO_CACHE_HEADER_SIZE + nr_of_files * 4 + 16)
+    goto fail;
+
+  total = IFO_CACHE_HEADER_SIZE + nr_of_files * 4 + 16;
+  for(i = 0; i < nr_of_files; i++) {
+    uint32_t file_size = get32(&data[IFO_CACHE_HEADER_SIZE + i * 4]);
+
+    if(file_size % DVD_BLOCK_LEN || file_size > size - total)
+      goto fail;
+    total += file_size;
+  }
+  if(total != size || !ifoCache_check_sum(data, size))
+    goto fail;
+
+  cache = malloc(sizeof(ifo_cache_t));
+  if(!cache)
+    goto fail;
+  memset(cache, 0, sizeof(ifo_cache_t));
+
+  memcpy(cache->discid, discid, 16);
+  memcpy(cache->probe, probe, 16);
+  cache->nr_of_files = nr_of_files;
+  cache->buffer = data;
+
+  p = &data[IFO_CACHE_HEADER_SIZE + nr_of_files * 4];
+  for(i = 0; i < nr_of_files; i++) {
+    cache->data[i] = p;
+    cache->size[i] = get32(&data[IFO_CACHE_HEADER_SIZE + i * 4]);
+    p += cache->size[i];
+  }
+
+  return cache;
+
+ fail:
+  fprintf(stderr, "libdvdread: Ignoring damaged or outdated IFO cache.\n");
+  free(data);
+  return NULL;
+}
+
+int ifoCacheStore(const char *dir, const ifo_cache_t *cache) {
+  unsigned char header[IFO_CACHE_HEADER_SIZE + IFO_CACHE_MAX_FILES * 4];
+  const unsigned char *parts[1 + IFO_CACHE_MAX_FILES];
+  size_t sizes[1 + IFO_CACHE_MAX_FILES];
+  char *path;
+  int i, ret;
+
+  /* Only the last part of the directory is made. */
+  mkdir(dir, 0755);
+
+  memcpy(header, IFO_CACHE_MAGIC, 6);
+  header[6] = IFO_CACHE_VERSION >> 8;
+  header[7] = IFO_CACHE_VERSION & 0xff;
+  memcpy(&header[8], cache->discid, 16);
+  memcpy(&header[24], cache->probe, 16);
+  put32(&header[40], (uint32_t)cache->nr_of_files);
+
+  parts[0] = header;
+  sizes[0] = IFO_CACHE_HEADER_SIZE + cache->nr_of_files * 4;
+  for(i = 0; i < cache->nr_of_files; i++) {
+    put32(&header[IFO_CACHE_HEADER_SIZE + i * 4], cache->size[i]);
+    parts[1 + i] = cache->data[i];
+    sizes[1 + i] = cache->size[i];
+  }
+
+  path = ifoCache_path(dir, cache->discid, IFO_CACHE_SUFFIX);
+  if(!path)
+    return -1;
+  ret = ifoCache_write_file(path, parts, sizes, 1 + cache->nr_of_files);
+  free(path);
+  if(ret < 0)
+    return ret;
+
+  /* The probe file goes last, it must never lead to a missing file. */
+  parts[0] = cache->discid;
+  sizes[0] = sizeof(cache->discid);
+  path = ifoCache_path(dir, cache->probe, IFO_CACHE_PROBE_SUFFIX);
+  if(!path)
+    return -1;
+  ret = ifoCache_write_file(path, parts, sizes, 1);
+  free(path);
+
+  return ret;
+}
+
+void ifoCacheFree(ifo_cache_t *cache) {
+  if(!cache)
+    return;
+
+  free(cache->buffer);
+  free(cache);
+}
@@ -0,0 +1,78 @@
+#ifndef IFO_CACHE_H_INCLUDED
+#define IFO_CACHE_H_INCLUDED
+
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <inttypes.h>
+
+/**
+ * The IFO cache keeps all the IFO files of a disc in one file on disk,
+ * named after the DVDDiscID() of the disc.  A second, small file named
+ * after the probe of the disc leads to it, the probe is worked out from
+ * the sizes of the IFO files and the first block of VIDEO_TS.IFO, so a
+ * disc can be found in the cache without reading its IFO files.
+ *
+ * Internal to libdvdread, see DVDSetIFOCache().
+ */
+
+/* Bump it whenever the layout below changes, older files are ignored. */
+#define IFO_CACHE_VERSION    1
+#define IFO_CACHE_MAX_FILES  100
+
+typedef struct {
+  unsigned char discid[16];
+  unsigned char probe[16];
+
+  /* VIDEO_TS.IFO first, then VTS_01_0.IFO and so on, they point into
+   * 'buffer'. */
+  int nr_of_files;
+  unsigned char *data[IFO_CACHE_MAX_FILES];
+  uint32_t size[IFO_CACHE_MAX_FILES];   /* in bytes, whole blocks */
+
+  unsigned char *buffer;
+} ifo_cache_t;
+
+/**
+ * cache = ifoCacheNew(sizes, nr_of_files);
+ *
+ * Allocates a cache with room for the given files, to be filled in by the
+ * caller.  The disc ID is the MD5 sum of the first ten files, as
+ * DVDDiscID() works it out, call ifoCacheSetID() once they are in.
+ */
+ifo_cache_t *ifoCacheNew(const uint32_t *sizes, int nr_of_files);
+void ifoCacheSetID(ifo_cache_t *cache);
+
+/**
+ * cache = ifoCacheLoad(dir, probe);
+ *
+ * Looks the disc with the given probe up in the cache directory.  Returns
+ * NULL if it is not there, or if the file is of another version, cut short
+ * or damaged.
+ */
+ifo_cache_t *ifoCacheLoad(const char *dir, const unsigned char *probe);
+
+/**
+ * ifoCacheStore(dir, cache);
+ *
+ * Writes the cache out to the cache directory, replacing any older file of
+ * the same disc.  Returns 0 on success, -1 on error.
+ */
+int ifoCacheStore(const char *dir, const ifo_cache_t *cache);
+
+void ifoCacheFree(ifo_cache_t *cache);
+
+#endif /* IFO_CACHE_H_INCLUDED */
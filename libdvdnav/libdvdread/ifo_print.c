@@ -1104,7 +1104,7 @@ void ifo_print(dvd_reader_t *dvd, int title) {
 
     printf("\nMenu PGCI Unit table\n");
     printf(  "--------------------\n");
-    if(ifohandle->pgci_ut) {
+    if(ifoGet_PGCI_UT(ifohandle)) {
       ifo_print_PGCI_UT(ifohandle->pgci_ut);
     } else {
       printf("No PGCI Unit table present\n");
@@ -1112,7 +1112,7 @@ void ifo_print(dvd_reader_t *dvd, int title) {
 
     printf("\nParental Manegment Information table\n");
     printf(  "------------------------------------\n");
-    if(ifohandle->ptl_mait) {
+    if(ifoGet_PTL_MAIT(ifohandle)) {
       ifo_print_PTL_MAIT(ifohandle->ptl_mait);
     } else {
       printf("No Parental Management Information present\n");
@@ -1120,11 +1120,15 @@ void ifo_print(dvd_reader_t *dvd, int title) {
 
     printf("\nVideo Title Set Attribute Table\n");
     printf(  "-------------------------------\n");
-    ifo_print_VTS_ATRT(ifohandle->vts_atrt);
+    if(ifoGet_VTS_ATRT(ifohandle)) {
+      ifo_print_VTS_ATRT(ifohandle->vts_atrt);
+    } else {
+      printf("No Video Title Set Attribute Table present\n");
+    }
 
     printf("\nText Data Manager Information\n");
     printf(  "-----------------------------\n");
-    if(ifohandle->txtdt_mgi) {
+    if(ifoGet_TXTDT_MGI(ifohandle)) {
       //ifo_print_TXTDT_MGI(&(vmgi->txtdt_mgi));
     } else {
       printf("No Text Data Manager Information present\n");
@@ -1132,7 +1136,7 @@ void ifo_print(dvd_reader_t *dvd, int title) {
 
     printf("\nMenu Cell Adress table\n");
     printf(  "-----------------\n");
-    if(ifohandle->menu_c_adt) {
+    if(ifoGet_C_ADT(ifohandle)) {
       ifo_print_C_ADT(ifohandle->menu_c_adt);
     } else {
       printf("No Menu Cell Adress table present\n");
@@ -1140,7 +1144,7 @@ void ifo_print(dvd_reader_t *dvd, int title) {
 
     printf("\nVideo Manager Menu VOBU address map\n");
     printf(  "-----------------\n");
-    if(ifohandle->menu_vobu_admap) {
+    if(ifoGet_VOBU_ADMAP(ifohandle)) {
       ifo_print_VOBU_ADMAP(ifohandle->menu_vobu_admap);
     } else {
       printf("No Menu VOBU address map present\n");
@@ -1163,7 +1167,7 @@ void ifo_print(dvd_reader_t *dvd, int title) {
 
     printf("\nMenu PGCI Unit table\n");
     printf(  "--------------------\n");
-    if(ifohandle->pgci_ut) {
+    if(ifoGet_PGCI_UT(ifohandle)) {
       ifo_print_PGCI_UT(ifohandle->pgci_ut);
     } else {
       printf("No Menu PGCI Unit table present\n");
@@ -1171,7 +1175,7 @@ void ifo_print(dvd_reader_t *dvd, int title) {
 
     printf("\nVTS Time Map table\n");
     printf(  "-----------------\n");
-    if(ifohandle->vts_tmapt) {
+    if(ifoGet_VTS_TMAPT(ifohandle)) {
       ifo_print_VTS_TMAPT(ifohandle->vts_tmapt);
     } else {
       printf("No VTS Time Map table present\n");
@@ -1179,7 +1183,7 @@ void ifo_print(dvd_reader_t *dvd, int title) {
 
     printf("\nMenu Cell Adress table\n");
     printf(  "-----------------\n");
-    if(ifohandle->menu_c_adt) {
+    if(ifoGet_C_ADT(ifohandle)) {
       ifo_print_C_ADT(ifohandle->menu_c_adt);
     } else {
       printf("No Cell Adress table present\n");
@@ -1187,7 +1191,7 @@ void ifo_print(dvd_reader_t *dvd, int title) {
 
     printf("\nVideo Title Set Menu VOBU address map\n");
     printf(  "-----------------\n");
-    if(ifohandle->menu_vobu_admap) {
+    if(ifoGet_VOBU_ADMAP(ifohandle)) {
       ifo_print_VOBU_ADMAP(ifohandle->menu_vobu_admap);
     } else {
       printf("No Menu VOBU address map present\n");
@@ -1195,11 +1199,19 @@ void ifo_print(dvd_reader_t *dvd, int title) {
 
     printf("\nCell Adress table\n");
     printf(  "-----------------\n");
-    ifo_print_C_ADT(ifohandle->vts_c_adt);
+    if(ifoGet_TITLE_C_ADT(ifohandle)) {
+      ifo_print_C_ADT(ifohandle->vts_c_adt);
+    } else {
+      printf("No Cell Adress table present\n");
+    }
 
     printf("\nVideo Title Set VOBU address map\n");
     printf(  "-----------------\n");
-    ifo_print_VOBU_ADMAP(ifohandle->vts_vobu_admap);
+    if(ifoGet_TITLE_VOBU_ADMAP(ifohandle)) {
+      ifo_print_VOBU_ADMAP(ifohandle->vts_vobu_admap);
+    } else {
+      printf("No VOBU address map present\n");
+    }
   }
 
   ifoClose(ifohandle);
@@ -85,16 +85,21 @@ static int ifoRead_VOBU_ADMAP_internal(ifo_handle_t *ifofile,
 static int ifoRead_PGCIT_internal(ifo_handle_t *ifofile, pgcit_t *pgcit,
                                   unsigned int offset);
 
-static void ifoFree_PGC(pgc_t *pgc);
-static void ifoFree_PGC_COMMAND_TBL(pgc_command_tbl_t *cmd_tbl);
-static void ifoFree_PGCIT_internal(pgcit_t *pgcit);
-
-static inline int DVDFileSeekForce_( dvd_file_t *dvd_file, uint32_t offset, int force_size ) {
-  return (DVDFileSeekForce(dvd_file, (int)offset, force_size) == (int)offset);
+/* The tables are parsed from the image of the IFO file through a cursor,
+ * moving it or reading past the end of the image fails. */
+static inline int ifoSeek(ifo_handle_t *ifofile, uint32_t offset) {
+  if(offset > ifofile->image_size)
+    return 0;
+  ifofile->image_pos = offset;
+  return 1;
 }
 
-static inline int DVDFileSeek_( dvd_file_t *dvd_file, uint32_t offset ) {
-  return (DVDFileSeek(dvd_file, (int)offset) == (int)offset);
+static inline int ifoReadBytes(ifo_handle_t *ifofile, void *data, size_t size) {
+  if(size > ifofile->image_size - ifofile->image_pos)
+    return 0;
+  memcpy(data, &ifofile->image[ifofile->image_pos], size);
+  ifofile->image_pos += size;
+  return 1;
 }
 
 static void read_video_attr(video_attr_t *va) {
@@ -276,38 +281,191 @@ static void read_playback_type(playback_type_t *pt) {
   pt->title_or_time_play              = dvdread_getbits(&state, 1);
 }
 
-static void free_ptl_mait(ptl_mait_t* ptl_mait, int num_entries) {
-  int i;
-  for (i = 0; i < num_entries; i++)
-    free(ptl_mait->countries[i].pf_ptl_mai);
+/* Longer than this an IFO file can't be, its header is broken. */
+#define IFO_MAX_SIZE (8 * 1024 * 1024)
+
+/* The handle, the image and every table parsed from it are allocated from
+ * a chain of arena blocks, the first one is sized so that normally nothing
+ * else is needed.  Tables are never freed on their own, ifoClose() frees
+ * the whole chain. */
+typedef struct ifo_arena_block_s {
+  struct ifo_arena_block_s *next;
+} ifo_arena_block_t;
+
+#define IFO_ARENA_ALIGN  16
+#define IFO_ARENA_BLOCK  (32 * 1024)
+/* No table is larger than this, a request for more comes from a broken
+ * length field. */
+#define IFO_ARENA_MAX    (4 * IFO_MAX_SIZE)
+
+static ifo_arena_block_t *ifoArena_block(size_t size) {
+  ifo_arena_block_t *block;
+
+  block = (ifo_arena_block_t *)malloc(sizeof(ifo_arena_block_t) + size);
+  if(block)
+    block->next = NULL;
+  return block;
+}
 
-  free(ptl_mait->countries);
-  free(ptl_mait);
+static void ifoArena_free(ifo_arena_block_t *block) {
+  while(block) {
+    ifo_arena_block_t *next = block->next;
+    free(block);
+    block = next;
+  }
 }
 
-ifo_handle_t *ifoOpen(dvd_reader_t *dvd, int title) {
+static void *ifoAllocAligned(ifo_handle_t *ifofile, size_t size,
+                             size_t align) {
+  size_t skip;
+  uint8_t *ptr;
+
+  if(size > IFO_ARENA_MAX)
+    return NULL;
+
+  skip = (align - ((uintptr_t)ifofile->arena_next & (align - 1))) & (align - 1);
+  if(size + skip > ifofile->arena_left) {
+    ifo_arena_block_t *block;
+    size_t block_size = size + align;
+
+    if(block_size < IFO_ARENA_BLOCK)
+      block_size = IFO_ARENA_BLOCK;
+    block = ifoArena_block(block_size);
+    if(!block)
+      return NULL;
+    block->next = ifofile->arena;
+    ifofile->arena = block;
+    ifofile->arena_next = (uint8_t *)(block + 1);
+    ifofile->arena_left = block_size;
+
+    skip = (align - ((uintptr_t)ifofile->arena_next & (align - 1)))
+      & (align - 1);
+  }
+
+  ptr = ifofile->arena_next + skip;
+  ifofile->arena_next = ptr + size;
+  ifofile->arena_left -= size + skip;
+  return ptr;
+}
+
+static inline void *ifoAlloc(ifo_handle_t *ifofile, size_t size) {
+  return ifoAllocAligned(ifofile, size, IFO_ARENA_ALIGN);
+}
+
+/* Makes a handle with room for an image of the given size and the first
+ * tables.  Most opens only parse a few tables, those read later chain
+ * further blocks. */
+static ifo_handle_t *ifoArena_new(uint32_t image_size) {
+  ifo_arena_block_t *block;
   ifo_handle_t *ifofile;
+  size_t size;
 
-  ifofile = (ifo_handle_t *)malloc(sizeof(ifo_handle_t));
-  if(!ifofile)
+  size = sizeof(ifo_handle_t) + IFO_ARENA_ALIGN
+    + image_size + DVD_BLOCK_LEN + IFO_ARENA_BLOCK;
+  block = ifoArena_block(size);
+  if(!block)
     return NULL;
 
+  ifofile = (ifo_handle_t *)(block + 1);
   memset(ifofile, 0, sizeof(ifo_handle_t));
+  ifofile->arena = block;
+  ifofile->arena_next = (uint8_t *)(ifofile + 1);
+  ifofile->arena_left = size - sizeof(ifo_handle_t);
+  return ifofile;
+}
+
+/* Reads the whole IFO file in, in one request where the file system has
+ * its size right.  The image is block aligned, so it is read straight in. */
+static ifo_handle_t *ifoRead_image(dvd_file_t *file) {
+  ifo_handle_t *ifofile;
+  uint32_t size, last_sector;
+  ssize_t blocks;
+  uint8_t *image;
+
+  blocks = DVDFileSize(file);
+  if(blocks < 1 && DVDFileSeekForce(file, DVD_BLOCK_LEN, 1) == DVD_BLOCK_LEN)
+    blocks = DVDFileSize(file);
+  if(blocks < 1 || blocks > IFO_MAX_SIZE / DVD_BLOCK_LEN)
+    return NULL;
+
+  size = blocks * DVD_BLOCK_LEN;
+  ifofile = ifoArena_new(size);
+  if(!ifofile)
+    return NULL;
+
+  image = (uint8_t *)ifoAllocAligned(ifofile, size, DVD_BLOCK_LEN);
+  if(!image
+     || DVDFileSeek(file, 0) != 0 || DVDReadBytes(file, image, size) != size) {
+    ifoClose(ifofile);
+    return NULL;
+  }
 
-  ifofile->file = DVDOpenFile(dvd, title, DVD_READ_INFO_FILE);
-  if(!ifofile->file) /* Should really catch any error and try to fallback */
-    ifofile->file = DVDOpenFile(dvd, title, DVD_READ_INFO_BACKUP_FILE);
-  if(!ifofile->file) {
+  /* Some images give the IFO file a shorter size than its header, the
+   * tables at the end are read in as well. */
+  last_sector = ((uint32_t)image[28] << 24) | ((uint32_t)image[29] << 16)
+    | ((uint32_t)image[30] << 8) | image[31];
+  if((!strncmp("DVDVIDEO-VMG", (char *)image, 12)
+      || !strncmp("DVDVIDEO-VTS", (char *)image, 12))
+     && last_sector >= (uint32_t)blocks
+     && last_sector < IFO_MAX_SIZE / DVD_BLOCK_LEN
+     && DVDFileSeekForce(file, size, last_sector + 1) == (int)size
+     && DVDFileSize(file) > blocks) {
+    uint32_t full_size = DVDFileSize(file) * DVD_BLOCK_LEN;
+    uint8_t *full_image;
+
+    /* Rare enough that the short image is left in the arena. */
+    full_image = (uint8_t *)ifoAllocAligned(ifofile, full_size, DVD_BLOCK_LEN);
+    if(full_image) {
+      memcpy(full_image, image, size);
+      if(DVDReadBytes(file, &full_image[size], full_size - size)
+         == full_size - size) {
+        image = full_image;
+        size = full_size;
+      }
+    }
+  }
+
+  ifofile->image = image;
+  ifofile->image_size = size;
+  ifofile->image_pos = 0;
+  return ifofile;
+}
+
+/* Opens the IFO file, or its backup if it can't be read, and reads it in.
+ * The file is closed again, the tables are parsed from memory. */
+static ifo_handle_t *ifoOpen_image(dvd_reader_t *dvd, int title) {
+  ifo_handle_t *ifofile = NULL;
+  dvd_file_t *file;
+
+  file = DVDOpenFile(dvd, title, DVD_READ_INFO_FILE);
+  if(file)
+    ifofile = ifoRead_image(file);
+  DVDCloseFile(file);
+  if(ifofile)
+    return ifofile;
+
+  file = DVDOpenFile(dvd, title, DVD_READ_INFO_BACKUP_FILE);
+  if(file)
+    ifofile = ifoRead_image(file);
+  DVDCloseFile(file);
+  return ifofile;
+}
+
+ifo_handle_t *ifoOpen(dvd_reader_t *dvd, int title) {
+  ifo_handle_t *ifofile;
+
+  ifofile = ifoOpen_image(dvd, title);
+  if(!ifofile) {
     if(title) {
-      fprintf(stderr, "libdvdread: Can't open file VTS_%02d_0.IFO.\n", title);
+      fprintf(stderr, "libdvdread: Can't read file VTS_%02d_0.IFO.\n", title);
     } else {
-      fprintf(stderr, "libdvdread: Can't open file VIDEO_TS.IFO.\n");
+      fprintf(stderr, "libdvdread: Can't read file VIDEO_TS.IFO.\n");
     }
-    free(ifofile);
     return NULL;
   }
 
-  /* First check if this is a VMGI file. */
+  /* First check if this is a VMGI file. The other tables are read in
+   * when they are first asked for, see the ifoGet_* calls. */
   if(ifoRead_VMG(ifofile)) {
 
     /* These are both mandatory. */
@@ -317,20 +475,6 @@ ifo_handle_t *ifoOpen(dvd_reader_t *dvd, int title) {
       return NULL;
     }
 
-    ifoRead_PGCI_UT(ifofile);
-    ifoRead_PTL_MAIT(ifofile);
-
-    /* This is also mandatory. */
-    if(!ifoRead_VTS_ATRT(ifofile)) {
-      fprintf(stderr, "libdvdread: Invalid main menu IFO (VIDEO_TS.IFO), ifoRead_VTS_ATRT() failed.\n");
-      ifoClose(ifofile);
-      return NULL;
-    }
-
-    ifoRead_TXTDT_MGI(ifofile);
-    ifoRead_C_ADT(ifofile);
-    ifoRead_VOBU_ADMAP(ifofile);
-
     return ifofile;
   }
 
@@ -343,19 +487,6 @@ ifo_handle_t *ifoOpen(dvd_reader_t *dvd, int title) {
       return NULL;
     }
 
-
-    ifoRead_PGCI_UT(ifofile);
-    ifoRead_VTS_TMAPT(ifofile);
-    ifoRead_C_ADT(ifofile);
-    ifoRead_VOBU_ADMAP(ifofile);
-
-    if(!ifoRead_TITLE_C_ADT(ifofile) || !ifoRead_TITLE_VOBU_ADMAP(ifofile)) {
-      fprintf(stderr, "libdvdread: Invalid title IFO (VTS_%02d_0.IFO).\n",
-              title);
-      ifoClose(ifofile);
-      return NULL;
-    }
-
     return ifofile;
   }
 
@@ -373,18 +504,9 @@ ifo_handle_t *ifoOpen(dvd_reader_t *dvd, int title) {
 ifo_handle_t *ifoOpenVMGI(dvd_reader_t *dvd) {
   ifo_handle_t *ifofile;
 
-  ifofile = (ifo_handle_t *)malloc(sizeof(ifo_handle_t));
-  if(!ifofile)
-    return NULL;
-
-  memset(ifofile, 0, sizeof(ifo_handle_t));
-
-  ifofile->file = DVDOpenFile(dvd, 0, DVD_READ_INFO_FILE);
-  if(!ifofile->file) /* Should really catch any error and try to fallback */
-    ifofile->file = DVDOpenFile(dvd, 0, DVD_READ_INFO_BACKUP_FILE);
-  if(!ifofile->file) {
-    fprintf(stderr, "libdvdread: Can't open file VIDEO_TS.IFO.\n");
-    free(ifofile);
+  ifofile = ifoOpen_image(dvd, 0);
+  if(!ifofile) {
+    fprintf(stderr, "libdvdread: Can't read file VIDEO_TS.IFO.\n");
     return NULL;
   }
 
@@ -400,24 +522,14 @@ ifo_handle_t *ifoOpenVMGI(dvd_reader_t *dvd) {
 ifo_handle_t *ifoOpenVTSI(dvd_reader_t *dvd, int title) {
   ifo_handle_t *ifofile;
 
-  ifofile = (ifo_handle_t *)malloc(sizeof(ifo_handle_t));
-  if(!ifofile)
-    return NULL;
-
-  memset(ifofile, 0, sizeof(ifo_handle_t));
-
   if(title <= 0 || title > 99) {
     fprintf(stderr, "libdvdread: ifoOpenVTSI invalid title (%d).\n", title);
-    free(ifofile);
     return NULL;
   }
 
-  ifofile->file = DVDOpenFile(dvd, title, DVD_READ_INFO_FILE);
-  if(!ifofile->file) /* Should really catch any error and try to fallback */
-    ifofile->file = DVDOpenFile(dvd, title, DVD_READ_INFO_BACKUP_FILE);
-  if(!ifofile->file) {
-    fprintf(stderr, "libdvdread: Can't open file VTS_%02d_0.IFO.\n", title);
-    free(ifofile);
+  ifofile = ifoOpen_image(dvd, title);
+  if(!ifofile) {
+    fprintf(stderr, "libdvdread: Can't read file VTS_%02d_0.IFO.\n", title);
     return NULL;
   }
 
@@ -436,56 +548,31 @@ void ifoClose(ifo_handle_t *ifofile) {
   if(!ifofile)
     return;
 
-  ifoFree_VOBU_ADMAP(ifofile);
-  ifoFree_TITLE_VOBU_ADMAP(ifofile);
-  ifoFree_C_ADT(ifofile);
-  ifoFree_TITLE_C_ADT(ifofile);
-  ifoFree_TXTDT_MGI(ifofile);
-  ifoFree_VTS_ATRT(ifofile);
-  ifoFree_PTL_MAIT(ifofile);
-  ifoFree_PGCI_UT(ifofile);
-  ifoFree_TT_SRPT(ifofile);
-  ifoFree_FP_PGC(ifofile);
-  ifoFree_PGCIT(ifofile);
-  ifoFree_VTS_PTT_SRPT(ifofile);
-  ifoFree_VTS_TMAPT(ifofile);
-
-  if(ifofile->vmgi_mat)
-    free(ifofile->vmgi_mat);
-
-  if(ifofile->vtsi_mat)
-    free(ifofile->vtsi_mat);
-
-  DVDCloseFile(ifofile->file);
-  ifofile->file = 0;
-  free(ifofile);
-  ifofile = 0;
+  /* The handle lives in the first block, the last one in the chain. */
+  ifoArena_free(ifofile->arena);
 }
 
 
 static int ifoRead_VMG(ifo_handle_t *ifofile) {
   vmgi_mat_t *vmgi_mat;
 
-  vmgi_mat = (vmgi_mat_t *)malloc(sizeof(vmgi_mat_t));
+  vmgi_mat = (vmgi_mat_t *)ifoAlloc(ifofile, sizeof(vmgi_mat_t));
   if(!vmgi_mat)
     return 0;
 
   ifofile->vmgi_mat = vmgi_mat;
 
-  if(!DVDFileSeek_(ifofile->file, 0)) {
-    free(ifofile->vmgi_mat);
+  if(!ifoSeek(ifofile, 0)) {
     ifofile->vmgi_mat = 0;
     return 0;
   }
 
-  if(!DVDReadBytes(ifofile->file, vmgi_mat, sizeof(vmgi_mat_t))) {
-    free(ifofile->vmgi_mat);
+  if(!ifoReadBytes(ifofile, vmgi_mat, sizeof(vmgi_mat_t))) {
     ifofile->vmgi_mat = 0;
     return 0;
   }
 
   if(strncmp("DVDVIDEO-VMG", vmgi_mat->vmg_identifier, 12) != 0) {
-    free(ifofile->vmgi_mat);
     ifofile->vmgi_mat = 0;
     return 0;
   }
@@ -558,26 +645,23 @@ static int ifoRead_VTS(ifo_handle_t *ifofile) {
   vtsi_mat_t *vtsi_mat;
   int i;
 
-  vtsi_mat = (vtsi_mat_t *)malloc(sizeof(vtsi_mat_t));
+  vtsi_mat = (vtsi_mat_t *)ifoAlloc(ifofile, sizeof(vtsi_mat_t));
   if(!vtsi_mat)
     return 0;
 
   ifofile->vtsi_mat = vtsi_mat;
 
-  if(!DVDFileSeek_(ifofile->file, 0)) {
-    free(ifofile->vtsi_mat);
+  if(!ifoSeek(ifofile, 0)) {
     ifofile->vtsi_mat = 0;
     return 0;
   }
 
-  if(!(DVDReadBytes(ifofile->file, vtsi_mat, sizeof(vtsi_mat_t)))) {
-    free(ifofile->vtsi_mat);
+  if(!(ifoReadBytes(ifofile, vtsi_mat, sizeof(vtsi_mat_t)))) {
     ifofile->vtsi_mat = 0;
     return 0;
   }
 
   if(strncmp("DVDVIDEO-VTS", vtsi_mat->vts_identifier, 12) != 0) {
-    free(ifofile->vtsi_mat);
     ifofile->vtsi_mat = 0;
     return 0;
   }
@@ -675,10 +759,10 @@ static int ifoRead_PGC_COMMAND_TBL(ifo_handle_t *ifofile,
 
   memset(cmd_tbl, 0, sizeof(pgc_command_tbl_t));
 
-  if(!DVDFileSeek_(ifofile->file, offset))
+  if(!ifoSeek(ifofile, offset))
     return 0;
 
-  if(!(DVDReadBytes(ifofile->file, cmd_tbl, PGC_COMMAND_TBL_SIZE)))
+  if(!(ifoReadBytes(ifofile, cmd_tbl, PGC_COMMAND_TBL_SIZE)))
     return 0;
 
   B2N_16(cmd_tbl->nr_of_pre);
@@ -689,50 +773,32 @@ static int ifoRead_PGC_COMMAND_TBL(ifo_handle_t *ifofile,
 
   if(cmd_tbl->nr_of_pre != 0) {
     unsigned int pre_cmds_size  = cmd_tbl->nr_of_pre * COMMAND_DATA_SIZE;
-    cmd_tbl->pre_cmds = (vm_cmd_t *)malloc(pre_cmds_size);
+    cmd_tbl->pre_cmds = (vm_cmd_t *)ifoAlloc(ifofile, pre_cmds_size);
     if(!cmd_tbl->pre_cmds)
       return 0;
 
-    if(!(DVDReadBytes(ifofile->file, cmd_tbl->pre_cmds, pre_cmds_size))) {
-      free(cmd_tbl->pre_cmds);
+    if(!(ifoReadBytes(ifofile, cmd_tbl->pre_cmds, pre_cmds_size)))
       return 0;
-    }
   }
 
   if(cmd_tbl->nr_of_post != 0) {
     unsigned int post_cmds_size = cmd_tbl->nr_of_post * COMMAND_DATA_SIZE;
-    cmd_tbl->post_cmds = (vm_cmd_t *)malloc(post_cmds_size);
-    if(!cmd_tbl->post_cmds) {
-      if(cmd_tbl->pre_cmds)
-	free(cmd_tbl->pre_cmds);
+    cmd_tbl->post_cmds = (vm_cmd_t *)ifoAlloc(ifofile, post_cmds_size);
+    if(!cmd_tbl->post_cmds)
       return 0;
-    }
-    if(!(DVDReadBytes(ifofile->file, cmd_tbl->post_cmds, post_cmds_size))) {
-      if(cmd_tbl->pre_cmds)
-	free(cmd_tbl->pre_cmds);
-      free(cmd_tbl->post_cmds);
+
+    if(!(ifoReadBytes(ifofile, cmd_tbl->post_cmds, post_cmds_size)))
       return 0;
-    }
   }
 
   if(cmd_tbl->nr_of_cell != 0) {
     unsigned int cell_cmds_size = cmd_tbl->nr_of_cell * COMMAND_DATA_SIZE;
-    cmd_tbl->cell_cmds = (vm_cmd_t *)malloc(cell_cmds_size);
-    if(!cmd_tbl->cell_cmds) {
-      if(cmd_tbl->pre_cmds)
-	free(cmd_tbl->pre_cmds);
-      if(cmd_tbl->post_cmds)
-	free(cmd_tbl->post_cmds);
+    cmd_tbl->cell_cmds = (vm_cmd_t *)ifoAlloc(ifofile, cell_cmds_size);
+    if(!cmd_tbl->cell_cmds)
       return 0;
-    }
-    if(!(DVDReadBytes(ifofile->file, cmd_tbl->cell_cmds, cell_cmds_size))) {
-      if(cmd_tbl->pre_cmds)
-	free(cmd_tbl->pre_cmds);
-      if(cmd_tbl->post_cmds)
-	free(cmd_tbl->post_cmds);
-      free(cmd_tbl->cell_cmds);
+
+    if(!(ifoReadBytes(ifofile, cmd_tbl->cell_cmds, cell_cmds_size)))
       return 0;
-    }
   }
 
   /*
@@ -742,27 +808,15 @@ static int ifoRead_PGC_COMMAND_TBL(ifo_handle_t *ifofile,
 }
 
 
-static void ifoFree_PGC_COMMAND_TBL(pgc_command_tbl_t *cmd_tbl) {
-  if(cmd_tbl) {
-    if(cmd_tbl->nr_of_pre && cmd_tbl->pre_cmds)
-      free(cmd_tbl->pre_cmds);
-    if(cmd_tbl->nr_of_post && cmd_tbl->post_cmds)
-      free(cmd_tbl->post_cmds);
-    if(cmd_tbl->nr_of_cell && cmd_tbl->cell_cmds)
-      free(cmd_tbl->cell_cmds);
-    free(cmd_tbl);
-  }
-}
-
 static int ifoRead_PGC_PROGRAM_MAP(ifo_handle_t *ifofile,
                                    pgc_program_map_t *program_map,
 				   unsigned int nr, unsigned int offset) {
   unsigned int size = nr * sizeof(pgc_program_map_t);
 
-  if(!DVDFileSeek_(ifofile->file, offset))
+  if(!ifoSeek(ifofile, offset))
     return 0;
 
-  if(!(DVDReadBytes(ifofile->file, program_map, size)))
+  if(!(ifoReadBytes(ifofile, program_map, size)))
     return 0;
 
   return 1;
@@ -774,10 +828,10 @@ static int ifoRead_CELL_PLAYBACK_TBL(ifo_handle_t *ifofile,
   unsigned int i;
   unsigned int size = nr * sizeof(cell_playback_t);
 
-  if(!DVDFileSeek_(ifofile->file, offset))
+  if(!ifoSeek(ifofile, offset))
     return 0;
 
-  if(!(DVDReadBytes(ifofile->file, cell_playback, size)))
+  if(!(ifoReadBytes(ifofile, cell_playback, size)))
     return 0;
 
   for(i = 0; i < nr; i++) {
@@ -799,10 +853,10 @@ static int ifoRead_CELL_POSITION_TBL(ifo_handle_t *ifofile,
   unsigned int i;
   unsigned int size = nr * sizeof(cell_position_t);
 
-  if(!DVDFileSeek_(ifofile->file, offset))
+  if(!ifoSeek(ifofile, offset))
     return 0;
 
-  if(!(DVDReadBytes(ifofile->file, cell_position, size)))
+  if(!(ifoReadBytes(ifofile, cell_position, size)))
     return 0;
 
   for(i = 0; i < nr; i++) {
@@ -816,10 +870,10 @@ static int ifoRead_CELL_POSITION_TBL(ifo_handle_t *ifofile,
 static int ifoRead_PGC(ifo_handle_t *ifofile, pgc_t *pgc, unsigned int offset) {
   unsigned int i;
 
-  if(!DVDFileSeek_(ifofile->file, offset))
+  if(!ifoSeek(ifofile, offset))
     return 0;
 
-  if(!(DVDReadBytes(ifofile->file, pgc, PGC_SIZE)))
+  if(!(ifoReadBytes(ifofile, pgc, PGC_SIZE)))
     return 0;
 
   read_user_ops(&pgc->prohibited_ops);
@@ -863,68 +917,54 @@ static int ifoRead_PGC(ifo_handle_t *ifofile, pgc_t *pgc, unsigned int offset) {
   }
 
   if(pgc->command_tbl_offset != 0) {
-    pgc->command_tbl = malloc(sizeof(pgc_command_tbl_t));
+    pgc->command_tbl = ifoAlloc(ifofile, sizeof(pgc_command_tbl_t));
     if(!pgc->command_tbl)
       return 0;
 
     if(!ifoRead_PGC_COMMAND_TBL(ifofile, pgc->command_tbl,
-                                offset + pgc->command_tbl_offset)) {
-      free(pgc->command_tbl);
+                                offset + pgc->command_tbl_offset))
       return 0;
-    }
   } else {
     pgc->command_tbl = NULL;
   }
 
   if(pgc->program_map_offset != 0 && pgc->nr_of_programs>0) {
-    pgc->program_map = malloc(pgc->nr_of_programs * sizeof(pgc_program_map_t));
-    if(!pgc->program_map) {
-      ifoFree_PGC_COMMAND_TBL(pgc->command_tbl);
+    pgc->program_map = ifoAlloc(ifofile, pgc->nr_of_programs
+                                * sizeof(pgc_program_map_t));
+    if(!pgc->program_map)
       return 0;
-    }
+
     if(!ifoRead_PGC_PROGRAM_MAP(ifofile, pgc->program_map,pgc->nr_of_programs,
-                                offset + pgc->program_map_offset)) {
-      ifoFree_PGC_COMMAND_TBL(pgc->command_tbl);
-      free(pgc->program_map);
+                                offset + pgc->program_map_offset))
       return 0;
-    }
   } else {
     pgc->program_map = NULL;
   }
 
   if(pgc->cell_playback_offset != 0 && pgc->nr_of_cells>0) {
-    pgc->cell_playback = malloc(pgc->nr_of_cells * sizeof(cell_playback_t));
-    if(!pgc->cell_playback) {
-      ifoFree_PGC_COMMAND_TBL(pgc->command_tbl);
-      if(pgc->program_map)
-	free(pgc->program_map);
+    pgc->cell_playback = ifoAlloc(ifofile, pgc->nr_of_cells
+                                  * sizeof(cell_playback_t));
+    if(!pgc->cell_playback)
       return 0;
-    }
+
     if(!ifoRead_CELL_PLAYBACK_TBL(ifofile, pgc->cell_playback,
 				  pgc->nr_of_cells,
-                                  offset + pgc->cell_playback_offset)) {
-      ifoFree_PGC_COMMAND_TBL(pgc->command_tbl);
-      if(pgc->program_map)
-	free(pgc->program_map);
-      free(pgc->cell_playback);
+                                  offset + pgc->cell_playback_offset))
       return 0;
-    }
   } else {
     pgc->cell_playback = NULL;
   }
 
   if(pgc->cell_position_offset != 0 && pgc->nr_of_cells>0) {
-    pgc->cell_position = malloc(pgc->nr_of_cells * sizeof(cell_position_t));
-    if(!pgc->cell_position) {
-      ifoFree_PGC(pgc);
+    pgc->cell_position = ifoAlloc(ifofile, pgc->nr_of_cells
+                                  * sizeof(cell_position_t));
+    if(!pgc->cell_position)
       return 0;
-    }
+
     if(!ifoRead_CELL_POSITION_TBL(ifofile, pgc->cell_position,
 				  pgc->nr_of_cells,
-                                  offset + pgc->cell_position_offset)) {
-      ifoFree_PGC(pgc);
+                                  offset + pgc->cell_position_offset))
       return 0;
-    }
   } else {
     pgc->cell_position = NULL;
   }
@@ -945,13 +985,12 @@ int ifoRead_FP_PGC(ifo_handle_t *ifofile) {
   if(ifofile->vmgi_mat->first_play_pgc == 0)
     return 1;
 
-  ifofile->first_play_pgc = (pgc_t *)malloc(sizeof(pgc_t));
+  ifofile->first_play_pgc = (pgc_t *)ifoAlloc(ifofile, sizeof(pgc_t));
   if(!ifofile->first_play_pgc)
     return 0;
 
   if(!ifoRead_PGC(ifofile, ifofile->first_play_pgc,
                   ifofile->vmgi_mat->first_play_pgc)) {
-    free(ifofile->first_play_pgc);
     ifofile->first_play_pgc = 0;
     return 0;
   }
@@ -959,27 +998,13 @@ int ifoRead_FP_PGC(ifo_handle_t *ifofile) {
   return 1;
 }
 
-static void ifoFree_PGC(pgc_t *pgc) {
-  if(pgc) {
-    ifoFree_PGC_COMMAND_TBL(pgc->command_tbl);
-    if(pgc->program_map)
-      free(pgc->program_map);
-    if(pgc->cell_playback)
-      free(pgc->cell_playback);
-    if(pgc->cell_position)
-      free(pgc->cell_position);
-  }
-}
-
+/* The ifoFree_* calls only drop the table from the handle, its memory
+ * goes with the rest of the arena in ifoClose(). */
 void ifoFree_FP_PGC(ifo_handle_t *ifofile) {
   if(!ifofile)
     return;
 
-  if(ifofile->first_play_pgc) {
-    ifoFree_PGC(ifofile->first_play_pgc);
-    free(ifofile->first_play_pgc);
-    ifofile->first_play_pgc = 0;
-  }
+  ifofile->first_play_pgc = 0;
 }
 
 
@@ -996,18 +1021,15 @@ int ifoRead_TT_SRPT(ifo_handle_t *ifofile) {
   if(ifofile->vmgi_mat->tt_srpt == 0) /* mandatory */
     return 0;
 
-  if(!DVDFileSeek_(ifofile->file, ifofile->vmgi_mat->tt_srpt * DVD_BLOCK_LEN))
+  if(!ifoSeek(ifofile, ifofile->vmgi_mat->tt_srpt * DVD_BLOCK_LEN))
     return 0;
 
-  tt_srpt = (tt_srpt_t *)malloc(sizeof(tt_srpt_t));
+  tt_srpt = (tt_srpt_t *)ifoAlloc(ifofile, sizeof(tt_srpt_t));
   if(!tt_srpt)
     return 0;
 
-  ifofile->tt_srpt = tt_srpt;
-
-  if(!(DVDReadBytes(ifofile->file, tt_srpt, TT_SRPT_SIZE))) {
+  if(!(ifoReadBytes(ifofile, tt_srpt, TT_SRPT_SIZE))) {
     fprintf(stderr, "libdvdread: Unable to read read TT_SRPT.\n");
-    free(tt_srpt);
     return 0;
   }
 
@@ -1016,15 +1038,12 @@ int ifoRead_TT_SRPT(ifo_handle_t *ifofile) {
 
   info_length = tt_srpt->last_byte + 1 - TT_SRPT_SIZE;
 
-  tt_srpt->title = (title_info_t *)malloc(info_length);
-  if(!tt_srpt->title) {
-    free(tt_srpt);
-    ifofile->tt_srpt = 0;
+  tt_srpt->title = (title_info_t *)ifoAlloc(ifofile, info_length);
+  if(!tt_srpt->title)
     return 0;
-  }
-  if(!(DVDReadBytes(ifofile->file, tt_srpt->title, info_length))) {
+
+  if(!(ifoReadBytes(ifofile, tt_srpt->title, info_length))) {
     fprintf(stderr, "libdvdread: Unable to read read TT_SRPT.\n");
-    ifoFree_TT_SRPT(ifofile);
     return 0;
   }
 
@@ -1068,6 +1087,7 @@ int ifoRead_TT_SRPT(ifo_handle_t *ifofile) {
   }
 #endif
 
+  ifofile->tt_srpt = tt_srpt;
   return 1;
 }
 
@@ -1076,11 +1096,7 @@ void ifoFree_TT_SRPT(ifo_handle_t *ifofile) {
   if(!ifofile)
     return;
 
-  if(ifofile->tt_srpt) {
-    free(ifofile->tt_srpt->title);
-    free(ifofile->tt_srpt);
-    ifofile->tt_srpt = 0;
-  }
+  ifofile->tt_srpt = 0;
 }
 
 
@@ -1098,19 +1114,16 @@ int ifoRead_VTS_PTT_SRPT(ifo_handle_t *ifofile) {
   if(ifofile->vtsi_mat->vts_ptt_srpt == 0) /* mandatory */
     return 0;
 
-  if(!DVDFileSeek_(ifofile->file,
+  if(!ifoSeek(ifofile,
 		   ifofile->vtsi_mat->vts_ptt_srpt * DVD_BLOCK_LEN))
     return 0;
 
-  vts_ptt_srpt = (vts_ptt_srpt_t *)malloc(sizeof(vts_ptt_srpt_t));
+  vts_ptt_srpt = (vts_ptt_srpt_t *)ifoAlloc(ifofile, sizeof(vts_ptt_srpt_t));
   if(!vts_ptt_srpt)
     return 0;
 
-  ifofile->vts_ptt_srpt = vts_ptt_srpt;
-
-  if(!(DVDReadBytes(ifofile->file, vts_ptt_srpt, VTS_PTT_SRPT_SIZE))) {
+  if(!(ifoReadBytes(ifofile, vts_ptt_srpt, VTS_PTT_SRPT_SIZE))) {
     fprintf(stderr, "libdvdread: Unable to read PTT search table.\n");
-    free(vts_ptt_srpt);
     return 0;
   }
 
@@ -1123,17 +1136,12 @@ int ifoRead_VTS_PTT_SRPT(ifo_handle_t *ifofile) {
 
   info_length = vts_ptt_srpt->last_byte + 1 - VTS_PTT_SRPT_SIZE;
 
-  data = (uint32_t *)malloc(info_length);
-  if(!data) {
-    free(vts_ptt_srpt);
-    ifofile->vts_ptt_srpt = 0;
+  data = (uint32_t *)ifoAlloc(ifofile, info_length);
+  if(!data)
     return 0;
-  }
-  if(!(DVDReadBytes(ifofile->file, data, info_length))) {
+
+  if(!(ifoReadBytes(ifofile, data, info_length))) {
     fprintf(stderr, "libdvdread: Unable to read PTT search table.\n");
-    free(vts_ptt_srpt);
-    free(data);
-    ifofile->vts_ptt_srpt = 0;
     return 0;
   }
 
@@ -1148,13 +1156,11 @@ int ifoRead_VTS_PTT_SRPT(ifo_handle_t *ifofile) {
 
   vts_ptt_srpt->ttu_offset = data;
 
-  vts_ptt_srpt->title = malloc(vts_ptt_srpt->nr_of_srpts * sizeof(ttu_t));
-  if(!vts_ptt_srpt->title) {
-    free(vts_ptt_srpt);
-    free(data);
-    ifofile->vts_ptt_srpt = 0;
+  vts_ptt_srpt->title = ifoAlloc(ifofile,
+                                 vts_ptt_srpt->nr_of_srpts * sizeof(ttu_t));
+  if(!vts_ptt_srpt->title)
     return 0;
-  }
+
   for(i = 0; i < vts_ptt_srpt->nr_of_srpts; i++) {
     int n;
     if(i < vts_ptt_srpt->nr_of_srpts - 1)
@@ -1168,15 +1174,10 @@ int ifoRead_VTS_PTT_SRPT(ifo_handle_t *ifofile) {
     CHECK_VALUE(n % 4 == 0);
 
     vts_ptt_srpt->title[i].nr_of_ptts = n / 4;
-    vts_ptt_srpt->title[i].ptt = malloc(n * sizeof(ptt_info_t));
-    if(!vts_ptt_srpt->title[i].ptt) {
-      for(n = 0; n < i; n++)
-        free(vts_ptt_srpt->title[n].ptt);
-      free(vts_ptt_srpt);
-      free(data);
-      ifofile->vts_ptt_srpt = 0;
+    vts_ptt_srpt->title[i].ptt = ifoAlloc(ifofile, n * sizeof(ptt_info_t));
+    if(!vts_ptt_srpt->title[i].ptt)
       return 0;
-    }
+
     for(j = 0; j < vts_ptt_srpt->title[i].nr_of_ptts; j++) {
       /* The assert placed here because of Magic Knight Rayearth Daybreak */
       CHECK_VALUE(data[i] + sizeof(ptt_info_t) <= vts_ptt_srpt->last_byte + 1);
@@ -1204,6 +1205,7 @@ int ifoRead_VTS_PTT_SRPT(ifo_handle_t *ifofile) {
     }
   }
 
+  ifofile->vts_ptt_srpt = vts_ptt_srpt;
   return 1;
 }
 
@@ -1212,15 +1214,7 @@ void ifoFree_VTS_PTT_SRPT(ifo_handle_t *ifofile) {
   if(!ifofile)
     return;
 
-  if(ifofile->vts_ptt_srpt) {
-    int i;
-    for(i = 0; i < ifofile->vts_ptt_srpt->nr_of_srpts; i++)
-      free(ifofile->vts_ptt_srpt->title[i].ptt);
-    free(ifofile->vts_ptt_srpt->ttu_offset);
-    free(ifofile->vts_ptt_srpt->title);
-    free(ifofile->vts_ptt_srpt);
-    ifofile->vts_ptt_srpt = 0;
-  }
+  ifofile->vts_ptt_srpt = 0;
 }
 
 
@@ -1238,20 +1232,15 @@ int ifoRead_PTL_MAIT(ifo_handle_t *ifofile) {
   if(ifofile->vmgi_mat->ptl_mait == 0)
     return 1;
 
-  if(!DVDFileSeek_(ifofile->file, ifofile->vmgi_mat->ptl_mait * DVD_BLOCK_LEN))
+  if(!ifoSeek(ifofile, ifofile->vmgi_mat->ptl_mait * DVD_BLOCK_LEN))
     return 0;
 
-  ptl_mait = (ptl_mait_t *)malloc(sizeof(ptl_mait_t));
+  ptl_mait = (ptl_mait_t *)ifoAlloc(ifofile, sizeof(ptl_mait_t));
   if(!ptl_mait)
     return 0;
 
-  ifofile->ptl_mait = ptl_mait;
-
-  if(!(DVDReadBytes(ifofile->file, ptl_mait, PTL_MAIT_SIZE))) {
-    free(ptl_mait);
-    ifofile->ptl_mait = 0;
+  if(!(ifoReadBytes(ifofile, ptl_mait, PTL_MAIT_SIZE)))
     return 0;
-  }
 
   B2N_16(ptl_mait->nr_of_countries);
   B2N_16(ptl_mait->nr_of_vtss);
@@ -1265,19 +1254,13 @@ int ifoRead_PTL_MAIT(ifo_handle_t *ifofile) {
 	      <= ptl_mait->last_byte + 1 - PTL_MAIT_SIZE);
 
   info_length = ptl_mait->nr_of_countries * sizeof(ptl_mait_country_t);
-  ptl_mait->countries = (ptl_mait_country_t *)malloc(info_length);
-  if(!ptl_mait->countries) {
-    free(ptl_mait);
-    ifofile->ptl_mait = 0;
+  ptl_mait->countries = (ptl_mait_country_t *)ifoAlloc(ifofile, info_length);
+  if(!ptl_mait->countries)
     return 0;
-  }
 
   for(i = 0; i < ptl_mait->nr_of_countries; i++) {
-    if(!(DVDReadBytes(ifofile->file, &ptl_mait->countries[i], PTL_MAIT_COUNTRY_SIZE))) {
+    if(!(ifoReadBytes(ifofile, &ptl_mait->countries[i], PTL_MAIT_COUNTRY_SIZE))) {
       fprintf(stderr, "libdvdread: Unable to read PTL_MAIT.\n");
-      free(ptl_mait->countries);
-      free(ptl_mait);
-      ifofile->ptl_mait = 0;
       return 0;
     }
   }
@@ -1297,33 +1280,29 @@ int ifoRead_PTL_MAIT(ifo_handle_t *ifofile) {
   for(i = 0; i < ptl_mait->nr_of_countries; i++) {
     uint16_t *pf_temp;
 
-    if(!DVDFileSeek_(ifofile->file,
+    if(!ifoSeek(ifofile,
 		     ifofile->vmgi_mat->ptl_mait * DVD_BLOCK_LEN
                      + ptl_mait->countries[i].pf_ptl_mai_start_byte)) {
       fprintf(stderr, "libdvdread: Unable to seak PTL_MAIT table.\n");
-      free(ptl_mait->countries);
-      free(ptl_mait);
       return 0;
     }
     info_length = (ptl_mait->nr_of_vtss + 1) * sizeof(pf_level_t);
     pf_temp = (uint16_t *)malloc(info_length);
-    if(!pf_temp) {
-      free_ptl_mait(ptl_mait, i);
+    if(!pf_temp)
       return 0;
-    }
-    if(!(DVDReadBytes(ifofile->file, pf_temp, info_length))) {
+
+    if(!(ifoReadBytes(ifofile, pf_temp, info_length))) {
        fprintf(stderr, "libdvdread: Unable to read PTL_MAIT table.\n");
        free(pf_temp);
-       free_ptl_mait(ptl_mait, i);
        return 0;
     }
     for (j = 0; j < ((ptl_mait->nr_of_vtss + 1) * 8); j++) {
         B2N_16(pf_temp[j]);
     }
-    ptl_mait->countries[i].pf_ptl_mai = (pf_level_t *)malloc(info_length);
+    ptl_mait->countries[i].pf_ptl_mai = (pf_level_t *)ifoAlloc(ifofile,
+                                                               info_length);
     if(!ptl_mait->countries[i].pf_ptl_mai) {
       free(pf_temp);
-      free_ptl_mait(ptl_mait, i);
       return 0;
     }
     { /* Transpose the array so we can use C indexing. */
@@ -1337,23 +1316,16 @@ int ifoRead_PTL_MAIT(ifo_handle_t *ifofile) {
       free(pf_temp);
     }
   }
+
+  ifofile->ptl_mait = ptl_mait;
   return 1;
 }
 
 void ifoFree_PTL_MAIT(ifo_handle_t *ifofile) {
-  unsigned int i;
-
   if(!ifofile)
     return;
 
-  if(ifofile->ptl_mait) {
-    for(i = 0; i < ifofile->ptl_mait->nr_of_countries; i++) {
-       free(ifofile->ptl_mait->countries[i].pf_ptl_mai);
-    }
-    free(ifofile->ptl_mait->countries);
-    free(ifofile->ptl_mait);
-    ifofile->ptl_mait = 0;
-  }
+  ifofile->ptl_mait = 0;
 }
 
 int ifoRead_VTS_TMAPT(ifo_handle_t *ifofile) {
@@ -1377,19 +1349,15 @@ int ifoRead_VTS_TMAPT(ifo_handle_t *ifofile) {
 
   offset = ifofile->vtsi_mat->vts_tmapt * DVD_BLOCK_LEN;
 
-  if(!DVDFileSeek_(ifofile->file, offset))
+  if(!ifoSeek(ifofile, offset))
     return 0;
 
-  vts_tmapt = (vts_tmapt_t *)malloc(sizeof(vts_tmapt_t));
+  vts_tmapt = (vts_tmapt_t *)ifoAlloc(ifofile, sizeof(vts_tmapt_t));
   if(!vts_tmapt)
     return 0;
 
-  ifofile->vts_tmapt = vts_tmapt;
-
-  if(!(DVDReadBytes(ifofile->file, vts_tmapt, VTS_TMAPT_SIZE))) {
+  if(!(ifoReadBytes(ifofile, vts_tmapt, VTS_TMAPT_SIZE))) {
     fprintf(stderr, "libdvdread: Unable to read VTS_TMAPT.\n");
-    free(vts_tmapt);
-    ifofile->vts_tmapt = NULL;
     return 0;
   }
 
@@ -1400,20 +1368,14 @@ int ifoRead_VTS_TMAPT(ifo_handle_t *ifofile) {
 
   info_length = vts_tmapt->nr_of_tmaps * 4;
 
-  vts_tmap_srp = (uint32_t *)malloc(info_length);
-  if(!vts_tmap_srp) {
-    free(vts_tmapt);
-    ifofile->vts_tmapt = NULL;
+  vts_tmap_srp = (uint32_t *)ifoAlloc(ifofile, info_length);
+  if(!vts_tmap_srp)
     return 0;
-  }
 
   vts_tmapt->tmap_offset = vts_tmap_srp;
 
-  if(!(DVDReadBytes(ifofile->file, vts_tmap_srp, info_length))) {
+  if(!(ifoReadBytes(ifofile, vts_tmap_srp, info_length))) {
     fprintf(stderr, "libdvdread: Unable to read VTS_TMAPT.\n");
-    free(vts_tmap_srp);
-    free(vts_tmapt);
-    ifofile->vts_tmapt = NULL;
     return 0;
   }
 
@@ -1424,25 +1386,16 @@ int ifoRead_VTS_TMAPT(ifo_handle_t *ifofile) {
 
   info_length = vts_tmapt->nr_of_tmaps * sizeof(vts_tmap_t);
 
-  vts_tmapt->tmap = (vts_tmap_t *)malloc(info_length);
-  if(!vts_tmapt->tmap) {
-    free(vts_tmap_srp);
-    free(vts_tmapt);
-    ifofile->vts_tmapt = NULL;
+  vts_tmapt->tmap = (vts_tmap_t *)ifoAlloc(ifofile, info_length);
+  if(!vts_tmapt->tmap)
     return 0;
-  }
-
-  memset(vts_tmapt->tmap, 0, info_length); /* So ifoFree_VTS_TMAPT works. */
 
   for(i = 0; i < vts_tmapt->nr_of_tmaps; i++) {
-    if(!DVDFileSeek_(ifofile->file, offset + vts_tmap_srp[i])) {
-      ifoFree_VTS_TMAPT(ifofile);
+    if(!ifoSeek(ifofile, offset + vts_tmap_srp[i]))
       return 0;
-    }
 
-    if(!(DVDReadBytes(ifofile->file, &vts_tmapt->tmap[i], VTS_TMAP_SIZE))) {
+    if(!(ifoReadBytes(ifofile, &vts_tmapt->tmap[i], VTS_TMAP_SIZE))) {
       fprintf(stderr, "libdvdread: Unable to read VTS_TMAP.\n");
-      ifoFree_VTS_TMAPT(ifofile);
       return 0;
     }
 
@@ -1456,15 +1409,12 @@ int ifoRead_VTS_TMAPT(ifo_handle_t *ifofile) {
 
     info_length = vts_tmapt->tmap[i].nr_of_entries * sizeof(map_ent_t);
 
-    vts_tmapt->tmap[i].map_ent = (map_ent_t *)malloc(info_length);
-    if(!vts_tmapt->tmap[i].map_ent) {
-      ifoFree_VTS_TMAPT(ifofile);
+    vts_tmapt->tmap[i].map_ent = (map_ent_t *)ifoAlloc(ifofile, info_length);
+    if(!vts_tmapt->tmap[i].map_ent)
       return 0;
-    }
 
-    if(!(DVDReadBytes(ifofile->file, vts_tmapt->tmap[i].map_ent, info_length))) {
+    if(!(ifoReadBytes(ifofile, vts_tmapt->tmap[i].map_ent, info_length))) {
       fprintf(stderr, "libdvdread: Unable to read VTS_TMAP_ENT.\n");
-      ifoFree_VTS_TMAPT(ifofile);
       return 0;
     }
 
@@ -1472,24 +1422,15 @@ int ifoRead_VTS_TMAPT(ifo_handle_t *ifofile) {
       B2N_32(vts_tmapt->tmap[i].map_ent[j]);
   }
 
+  ifofile->vts_tmapt = vts_tmapt;
   return 1;
 }
 
 void ifoFree_VTS_TMAPT(ifo_handle_t *ifofile) {
-  unsigned int i;
-
   if(!ifofile)
     return;
 
-  if(ifofile->vts_tmapt) {
-    for(i = 0; i < ifofile->vts_tmapt->nr_of_tmaps; i++)
-      if(ifofile->vts_tmapt->tmap[i].map_ent)
-	free(ifofile->vts_tmapt->tmap[i].map_ent);
-    free(ifofile->vts_tmapt->tmap);
-    free(ifofile->vts_tmapt->tmap_offset);
-    free(ifofile->vts_tmapt);
-    ifofile->vts_tmapt = NULL;
-  }
+  ifofile->vts_tmapt = NULL;
 }
 
 
@@ -1504,13 +1445,12 @@ int ifoRead_TITLE_C_ADT(ifo_handle_t *ifofile) {
   if(ifofile->vtsi_mat->vts_c_adt == 0) /* mandatory */
     return 0;
 
-  ifofile->vts_c_adt = (c_adt_t *)malloc(sizeof(c_adt_t));
+  ifofile->vts_c_adt = (c_adt_t *)ifoAlloc(ifofile, sizeof(c_adt_t));
   if(!ifofile->vts_c_adt)
     return 0;
 
   if(!ifoRead_C_ADT_internal(ifofile, ifofile->vts_c_adt,
                              ifofile->vtsi_mat->vts_c_adt)) {
-    free(ifofile->vts_c_adt);
     ifofile->vts_c_adt = 0;
     return 0;
   }
@@ -1536,12 +1476,11 @@ int ifoRead_C_ADT(ifo_handle_t *ifofile) {
     return 0;
   }
 
-  ifofile->menu_c_adt = (c_adt_t *)malloc(sizeof(c_adt_t));
+  ifofile->menu_c_adt = (c_adt_t *)ifoAlloc(ifofile, sizeof(c_adt_t));
   if(!ifofile->menu_c_adt)
     return 0;
 
   if(!ifoRead_C_ADT_internal(ifofile, ifofile->menu_c_adt, sector)) {
-    free(ifofile->menu_c_adt);
     ifofile->menu_c_adt = 0;
     return 0;
   }
@@ -1553,10 +1492,10 @@ static int ifoRead_C_ADT_internal(ifo_handle_t *ifofile,
                                   c_adt_t *c_adt, unsigned int sector) {
   int i, info_length;
 
-  if(!DVDFileSeek_(ifofile->file, sector * DVD_BLOCK_LEN))
+  if(!ifoSeek(ifofile, sector * DVD_BLOCK_LEN))
     return 0;
 
-  if(!(DVDReadBytes(ifofile->file, c_adt, C_ADT_SIZE)))
+  if(!(ifoReadBytes(ifofile, c_adt, C_ADT_SIZE)))
     return 0;
 
   B2N_16(c_adt->nr_of_vobs);
@@ -1578,15 +1517,13 @@ static int ifoRead_C_ADT_internal(ifo_handle_t *ifofile,
     c_adt->nr_of_vobs = info_length / sizeof(cell_adr_t);
   }
 
-  c_adt->cell_adr_table = (cell_adr_t *)malloc(info_length);
+  c_adt->cell_adr_table = (cell_adr_t *)ifoAlloc(ifofile, info_length);
   if(!c_adt->cell_adr_table)
     return 0;
 
   if(info_length &&
-     !(DVDReadBytes(ifofile->file, c_adt->cell_adr_table, info_length))) {
-    free(c_adt->cell_adr_table);
+     !(ifoReadBytes(ifofile, c_adt->cell_adr_table, info_length)))
     return 0;
-  }
 
   for(i = 0; i < info_length/sizeof(cell_adr_t); i++) {
     B2N_16(c_adt->cell_adr_table[i].vob_id);
@@ -1604,19 +1541,10 @@ static int ifoRead_C_ADT_internal(ifo_handle_t *ifofile,
   return 1;
 }
 
-
-static void ifoFree_C_ADT_internal(c_adt_t *c_adt) {
-  if(c_adt) {
-    free(c_adt->cell_adr_table);
-    free(c_adt);
-  }
-}
-
 void ifoFree_C_ADT(ifo_handle_t *ifofile) {
   if(!ifofile)
     return;
 
-  ifoFree_C_ADT_internal(ifofile->menu_c_adt);
   ifofile->menu_c_adt = 0;
 }
 
@@ -1624,7 +1552,6 @@ void ifoFree_TITLE_C_ADT(ifo_handle_t *ifofile) {
   if(!ifofile)
     return;
 
-  ifoFree_C_ADT_internal(ifofile->vts_c_adt);
   ifofile->vts_c_adt = 0;
 }
 
@@ -1638,13 +1565,13 @@ int ifoRead_TITLE_VOBU_ADMAP(ifo_handle_t *ifofile) {
   if(ifofile->vtsi_mat->vts_vobu_admap == 0) /* mandatory */
     return 0;
 
-  ifofile->vts_vobu_admap = (vobu_admap_t *)malloc(sizeof(vobu_admap_t));
+  ifofile->vts_vobu_admap = (vobu_admap_t *)ifoAlloc(ifofile,
+                                                     sizeof(vobu_admap_t));
   if(!ifofile->vts_vobu_admap)
     return 0;
 
   if(!ifoRead_VOBU_ADMAP_internal(ifofile, ifofile->vts_vobu_admap,
                                   ifofile->vtsi_mat->vts_vobu_admap)) {
-    free(ifofile->vts_vobu_admap);
     ifofile->vts_vobu_admap = 0;
     return 0;
   }
@@ -1670,12 +1597,12 @@ int ifoRead_VOBU_ADMAP(ifo_handle_t *ifofile) {
     return 0;
   }
 
-  ifofile->menu_vobu_admap = (vobu_admap_t *)malloc(sizeof(vobu_admap_t));
+  ifofile->menu_vobu_admap = (vobu_admap_t *)ifoAlloc(ifofile,
+                                                      sizeof(vobu_admap_t));
   if(!ifofile->menu_vobu_admap)
     return 0;
 
   if(!ifoRead_VOBU_ADMAP_internal(ifofile, ifofile->menu_vobu_admap, sector)) {
-    free(ifofile->menu_vobu_admap);
     ifofile->menu_vobu_admap = 0;
     return 0;
   }
@@ -1689,10 +1616,10 @@ static int ifoRead_VOBU_ADMAP_internal(ifo_handle_t *ifofile,
   unsigned int i;
   int info_length;
 
-  if(!DVDFileSeekForce_(ifofile->file, sector * DVD_BLOCK_LEN, sector))
+  if(!ifoSeek(ifofile, sector * DVD_BLOCK_LEN))
     return 0;
 
-  if(!(DVDReadBytes(ifofile->file, vobu_admap, VOBU_ADMAP_SIZE)))
+  if(!(ifoReadBytes(ifofile, vobu_admap, VOBU_ADMAP_SIZE)))
     return 0;
 
   B2N_32(vobu_admap->last_byte);
@@ -1703,16 +1630,14 @@ static int ifoRead_VOBU_ADMAP_internal(ifo_handle_t *ifofile,
      Titles with a VOBS that has no VOBUs. */
   CHECK_VALUE(info_length % sizeof(uint32_t) == 0);
 
-  vobu_admap->vobu_start_sectors = (uint32_t *)malloc(info_length);
-  if(!vobu_admap->vobu_start_sectors) {
+  vobu_admap->vobu_start_sectors = (uint32_t *)ifoAlloc(ifofile, info_length);
+  if(!vobu_admap->vobu_start_sectors)
     return 0;
-  }
+
   if(info_length &&
-     !(DVDReadBytes(ifofile->file,
-		    vobu_admap->vobu_start_sectors, info_length))) {
-    free(vobu_admap->vobu_start_sectors);
+     !(ifoReadBytes(ifofile,
+		    vobu_admap->vobu_start_sectors, info_length)))
     return 0;
-  }
 
   for(i = 0; i < info_length/sizeof(uint32_t); i++)
     B2N_32(vobu_admap->vobu_start_sectors[i]);
@@ -1720,19 +1645,10 @@ static int ifoRead_VOBU_ADMAP_internal(ifo_handle_t *ifofile,
   return 1;
 }
 
-
-static void ifoFree_VOBU_ADMAP_internal(vobu_admap_t *vobu_admap) {
-  if(vobu_admap) {
-    free(vobu_admap->vobu_start_sectors);
-    free(vobu_admap);
-  }
-}
-
 void ifoFree_VOBU_ADMAP(ifo_handle_t *ifofile) {
   if(!ifofile)
     return;
 
-  ifoFree_VOBU_ADMAP_internal(ifofile->menu_vobu_admap);
   ifofile->menu_vobu_admap = 0;
 }
 
@@ -1740,7 +1656,6 @@ void ifoFree_TITLE_VOBU_ADMAP(ifo_handle_t *ifofile) {
   if(!ifofile)
     return;
 
-  ifoFree_VOBU_ADMAP_internal(ifofile->vts_vobu_admap);
   ifofile->vts_vobu_admap = 0;
 }
 
@@ -1755,13 +1670,12 @@ int ifoRead_PGCIT(ifo_handle_t *ifofile) {
   if(ifofile->vtsi_mat->vts_pgcit == 0) /* mandatory */
     return 0;
 
-  ifofile->vts_pgcit = (pgcit_t *)malloc(sizeof(pgcit_t));
+  ifofile->vts_pgcit = (pgcit_t *)ifoAlloc(ifofile, sizeof(pgcit_t));
   if(!ifofile->vts_pgcit)
     return 0;
 
   if(!ifoRead_PGCIT_internal(ifofile, ifofile->vts_pgcit,
                              ifofile->vtsi_mat->vts_pgcit * DVD_BLOCK_LEN)) {
-    free(ifofile->vts_pgcit);
     ifofile->vts_pgcit = 0;
     return 0;
   }
@@ -1772,12 +1686,12 @@ int ifoRead_PGCIT(ifo_handle_t *ifofile) {
 static int ifoRead_PGCIT_internal(ifo_handle_t *ifofile, pgcit_t *pgcit,
                                   unsigned int offset) {
   int i, info_length;
-  uint8_t *data, *ptr;
+  uint8_t *ptr;
 
-  if(!DVDFileSeek_(ifofile->file, offset))
+  if(!ifoSeek(ifofile, offset))
     return 0;
 
-  if(!(DVDReadBytes(ifofile->file, pgcit, PGCIT_SIZE)))
+  if(!(ifoReadBytes(ifofile, pgcit, PGCIT_SIZE)))
     return 0;
 
   B2N_16(pgcit->nr_of_pgci_srp);
@@ -1789,79 +1703,45 @@ static int ifoRead_PGCIT_internal(ifo_handle_t *ifofile, pgcit_t *pgcit,
      Titles with 0 PTTs. */
   CHECK_VALUE(pgcit->nr_of_pgci_srp < 10000); /* ?? seen max of 1338 */
 
+  /* The search pointers are parsed in place, straight from the image. */
   info_length = pgcit->nr_of_pgci_srp * PGCI_SRP_SIZE;
-  data = malloc(info_length);
-  if(!data)
+  if(info_length > ifofile->image_size - ifofile->image_pos)
     return 0;
 
-  if(info_length && !(DVDReadBytes(ifofile->file, data, info_length))) {
-    free(data);
+  pgcit->pgci_srp = ifoAlloc(ifofile,
+                             pgcit->nr_of_pgci_srp * sizeof(pgci_srp_t));
+  if(!pgcit->pgci_srp)
     return 0;
-  }
 
-  pgcit->pgci_srp = malloc(pgcit->nr_of_pgci_srp * sizeof(pgci_srp_t));
-  if(!pgcit->pgci_srp) {
-    free(data);
-    return 0;
-  }
-  ptr = data;
+  ptr = &ifofile->image[ifofile->image_pos];
   for(i = 0; i < pgcit->nr_of_pgci_srp; i++) {
     memcpy(&pgcit->pgci_srp[i], ptr, PGCI_SRP_SIZE);
     ptr += PGCI_SRP_SIZE;
     read_pgci_srp(&pgcit->pgci_srp[i]);
     CHECK_VALUE(pgcit->pgci_srp[i].unknown1 == 0);
   }
-  free(data);
 
   for(i = 0; i < pgcit->nr_of_pgci_srp; i++)
     CHECK_VALUE(pgcit->pgci_srp[i].pgc_start_byte + PGC_SIZE <= pgcit->last_byte+1);
 
   for(i = 0; i < pgcit->nr_of_pgci_srp; i++) {
-    pgcit->pgci_srp[i].pgc = malloc(sizeof(pgc_t));
-    if(!pgcit->pgci_srp[i].pgc) {
-      int j;
-      for(j = 0; j < i; j++) {
-        ifoFree_PGC(pgcit->pgci_srp[j].pgc);
-        free(pgcit->pgci_srp[j].pgc);
-      }
-      goto fail;
-    }
-    if(!ifoRead_PGC(ifofile, pgcit->pgci_srp[i].pgc,
-                    offset + pgcit->pgci_srp[i].pgc_start_byte)) {
-      int j;
-      for(j = 0; j < i; j++) {
-        ifoFree_PGC(pgcit->pgci_srp[j].pgc);
-        free(pgcit->pgci_srp[j].pgc);
-      }
-      goto fail;
+    pgcit->pgci_srp[i].pgc = ifoAlloc(ifofile, sizeof(pgc_t));
+    if(!pgcit->pgci_srp[i].pgc
+       || !ifoRead_PGC(ifofile, pgcit->pgci_srp[i].pgc,
+                       offset + pgcit->pgci_srp[i].pgc_start_byte)) {
+      pgcit->pgci_srp = NULL;
+      return 0;
     }
   }
 
   return 1;
-fail:
-  free(pgcit->pgci_srp);
-  pgcit->pgci_srp = NULL;
-  return 0;
-}
-
-static void ifoFree_PGCIT_internal(pgcit_t *pgcit) {
-  if(pgcit) {
-    int i;
-    for(i = 0; i < pgcit->nr_of_pgci_srp; i++)
-      ifoFree_PGC(pgcit->pgci_srp[i].pgc);
-    free(pgcit->pgci_srp);
-  }
 }
 
 void ifoFree_PGCIT(ifo_handle_t *ifofile) {
   if(!ifofile)
     return;
 
-  if(ifofile->vts_pgcit) {
-    ifoFree_PGCIT_internal(ifofile->vts_pgcit);
-    free(ifofile->vts_pgcit);
-    ifofile->vts_pgcit = 0;
-  }
+  ifofile->vts_pgcit = 0;
 }
 
 
@@ -1870,7 +1750,7 @@ int ifoRead_PGCI_UT(ifo_handle_t *ifofile) {
   unsigned int sector;
   unsigned int i;
   int info_length;
-  uint8_t *data, *ptr;
+  uint8_t *ptr;
 
   if(!ifofile)
     return 0;
@@ -1887,23 +1767,15 @@ int ifoRead_PGCI_UT(ifo_handle_t *ifofile) {
     return 0;
   }
 
-  ifofile->pgci_ut = (pgci_ut_t *)malloc(sizeof(pgci_ut_t));
-  if(!ifofile->pgci_ut)
+  pgci_ut = (pgci_ut_t *)ifoAlloc(ifofile, sizeof(pgci_ut_t));
+  if(!pgci_ut)
     return 0;
 
-  if(!DVDFileSeek_(ifofile->file, sector * DVD_BLOCK_LEN)) {
-    free(ifofile->pgci_ut);
-    ifofile->pgci_ut = 0;
+  if(!ifoSeek(ifofile, sector * DVD_BLOCK_LEN))
     return 0;
-  }
 
-  if(!(DVDReadBytes(ifofile->file, ifofile->pgci_ut, PGCI_UT_SIZE))) {
-    free(ifofile->pgci_ut);
-    ifofile->pgci_ut = 0;
+  if(!(ifoReadBytes(ifofile, pgci_ut, PGCI_UT_SIZE)))
     return 0;
-  }
-
-  pgci_ut = ifofile->pgci_ut;
 
   B2N_16(pgci_ut->nr_of_lus);
   B2N_32(pgci_ut->last_byte);
@@ -1913,35 +1785,22 @@ int ifoRead_PGCI_UT(ifo_handle_t *ifofile) {
   CHECK_VALUE(pgci_ut->nr_of_lus < 100); /* ?? 3-4 ? */
   CHECK_VALUE((uint32_t)pgci_ut->nr_of_lus * PGCI_LU_SIZE < pgci_ut->last_byte);
 
+  /* The language units are parsed in place, straight from the image. */
   info_length = pgci_ut->nr_of_lus * PGCI_LU_SIZE;
-  data = malloc(info_length);
-  if(!data) {
-    free(pgci_ut);
-    ifofile->pgci_ut = 0;
+  if(info_length > ifofile->image_size - ifofile->image_pos)
     return 0;
-  }
-  if(!(DVDReadBytes(ifofile->file, data, info_length))) {
-    free(data);
-    free(pgci_ut);
-    ifofile->pgci_ut = 0;
+
+  pgci_ut->lu = ifoAlloc(ifofile, pgci_ut->nr_of_lus * sizeof(pgci_lu_t));
+  if(!pgci_ut->lu)
     return 0;
-  }
 
-  pgci_ut->lu = malloc(pgci_ut->nr_of_lus * sizeof(pgci_lu_t));
-  if(!pgci_ut->lu) {
-    free(data);
-    free(pgci_ut);
-    ifofile->pgci_ut = 0;
-   return 0;
-  }
-  ptr = data;
+  ptr = &ifofile->image[ifofile->image_pos];
   for(i = 0; i < pgci_ut->nr_of_lus; i++) {
     memcpy(&pgci_ut->lu[i], ptr, PGCI_LU_SIZE);
     ptr += PGCI_LU_SIZE;
     B2N_16(pgci_ut->lu[i].lang_code);
     B2N_32(pgci_ut->lu[i].lang_start_byte);
   }
-  free(data);
 
   for(i = 0; i < pgci_ut->nr_of_lus; i++) {
     /* Maybe this is only defined for v1.1 and later titles? */
@@ -1957,57 +1816,30 @@ int ifoRead_PGCI_UT(ifo_handle_t *ifofile) {
   }
 
   for(i = 0; i < pgci_ut->nr_of_lus; i++) {
-    pgci_ut->lu[i].pgcit = malloc(sizeof(pgcit_t));
-    if(!pgci_ut->lu[i].pgcit) {
-      unsigned int j;
-      for(j = 0; j < i; j++) {
-        ifoFree_PGCIT_internal(pgci_ut->lu[j].pgcit);
-        free(pgci_ut->lu[j].pgcit);
-      }
-      free(pgci_ut->lu);
-      free(pgci_ut);
-      ifofile->pgci_ut = 0;
+    pgci_ut->lu[i].pgcit = ifoAlloc(ifofile, sizeof(pgcit_t));
+    if(!pgci_ut->lu[i].pgcit)
       return 0;
-    }
+
     if(!ifoRead_PGCIT_internal(ifofile, pgci_ut->lu[i].pgcit,
                                sector * DVD_BLOCK_LEN
-                               + pgci_ut->lu[i].lang_start_byte)) {
-      unsigned int j;
-      for(j = 0; j < i; j++) {
-        ifoFree_PGCIT_internal(pgci_ut->lu[j].pgcit);
-        free(pgci_ut->lu[j].pgcit);
-      }
-      free(pgci_ut->lu[i].pgcit);
-      free(pgci_ut->lu);
-      free(pgci_ut);
-      ifofile->pgci_ut = 0;
+                               + pgci_ut->lu[i].lang_start_byte))
       return 0;
-    }
     /*
 		 * FIXME: Iterate and verify that all menus that should exists accordingly
 		 * to pgci_ut->lu[i].exists really do?
 		 */
   }
 
+  ifofile->pgci_ut = pgci_ut;
   return 1;
 }
 
 
 void ifoFree_PGCI_UT(ifo_handle_t *ifofile) {
-  unsigned int i;
-
   if(!ifofile)
     return;
 
-  if(ifofile->pgci_ut) {
-    for(i = 0; i < ifofile->pgci_ut->nr_of_lus; i++) {
-      ifoFree_PGCIT_internal(ifofile->pgci_ut->lu[i].pgcit);
-      free(ifofile->pgci_ut->lu[i].pgcit);
-    }
-    free(ifofile->pgci_ut->lu);
-    free(ifofile->pgci_ut);
-    ifofile->pgci_ut = 0;
-  }
+  ifofile->pgci_ut = 0;
 }
 
 static int ifoRead_VTS_ATTRIBUTES(ifo_handle_t *ifofile,
@@ -2015,10 +1847,10 @@ static int ifoRead_VTS_ATTRIBUTES(ifo_handle_t *ifofile,
                                   unsigned int offset) {
   unsigned int i;
 
-  if(!DVDFileSeek_(ifofile->file, offset))
+  if(!ifoSeek(ifofile, offset))
     return 0;
 
-  if(!(DVDReadBytes(ifofile->file, vts_attributes, sizeof(vts_attributes_t))))
+  if(!(ifoReadBytes(ifofile, vts_attributes, sizeof(vts_attributes_t))))
     return 0;
 
   read_video_attr(&vts_attributes->vtsm_vobs_attr);
@@ -2078,20 +1910,15 @@ int ifoRead_VTS_ATRT(ifo_handle_t *ifofile) {
     return 0;
 
   sector = ifofile->vmgi_mat->vts_atrt;
-  if(!DVDFileSeek_(ifofile->file, sector * DVD_BLOCK_LEN))
+  if(!ifoSeek(ifofile, sector * DVD_BLOCK_LEN))
     return 0;
 
-  vts_atrt = (vts_atrt_t *)malloc(sizeof(vts_atrt_t));
+  vts_atrt = (vts_atrt_t *)ifoAlloc(ifofile, sizeof(vts_atrt_t));
   if(!vts_atrt)
     return 0;
 
-  ifofile->vts_atrt = vts_atrt;
-
-  if(!(DVDReadBytes(ifofile->file, vts_atrt, VTS_ATRT_SIZE))) {
-    free(vts_atrt);
-    ifofile->vts_atrt = 0;
+  if(!(ifoReadBytes(ifofile, vts_atrt, VTS_ATRT_SIZE)))
     return 0;
-  }
 
   B2N_16(vts_atrt->nr_of_vtss);
   B2N_32(vts_atrt->last_byte);
@@ -2103,21 +1930,14 @@ int ifoRead_VTS_ATRT(ifo_handle_t *ifofile) {
          VTS_ATRT_SIZE < vts_atrt->last_byte + 1);
 
   info_length = vts_atrt->nr_of_vtss * sizeof(uint32_t);
-  data = (uint32_t *)malloc(info_length);
-  if(!data) {
-    free(vts_atrt);
-    ifofile->vts_atrt = 0;
+  data = (uint32_t *)ifoAlloc(ifofile, info_length);
+  if(!data)
     return 0;
-  }
 
   vts_atrt->vts_atrt_offsets = data;
 
-  if(!(DVDReadBytes(ifofile->file, data, info_length))) {
-    free(data);
-    free(vts_atrt);
-    ifofile->vts_atrt = 0;
+  if(!(ifoReadBytes(ifofile, data, info_length)))
     return 0;
-  }
 
   for(i = 0; i < vts_atrt->nr_of_vtss; i++) {
     B2N_32(data[i]);
@@ -2125,28 +1945,22 @@ int ifoRead_VTS_ATRT(ifo_handle_t *ifofile) {
   }
 
   info_length = vts_atrt->nr_of_vtss * sizeof(vts_attributes_t);
-  vts_atrt->vts = (vts_attributes_t *)malloc(info_length);
-  if(!vts_atrt->vts) {
-    free(data);
-    free(vts_atrt);
-    ifofile->vts_atrt = 0;
+  vts_atrt->vts = (vts_attributes_t *)ifoAlloc(ifofile, info_length);
+  if(!vts_atrt->vts)
     return 0;
-  }
+
   for(i = 0; i < vts_atrt->nr_of_vtss; i++) {
     unsigned int offset = data[i];
     if(!ifoRead_VTS_ATTRIBUTES(ifofile, &(vts_atrt->vts[i]),
-                               (sector * DVD_BLOCK_LEN) + offset)) {
-      free(data);
-      free(vts_atrt);
-      ifofile->vts_atrt = 0;
+                               (sector * DVD_BLOCK_LEN) + offset))
       return 0;
-    }
 
     /* This assert cant be in ifoRead_VTS_ATTRIBUTES */
     CHECK_VALUE(offset + vts_atrt->vts[i].last_byte <= vts_atrt->last_byte + 1);
     /* Is this check correct? */
   }
 
+  ifofile->vts_atrt = vts_atrt;
   return 1;
 }
 
@@ -2155,12 +1969,7 @@ void ifoFree_VTS_ATRT(ifo_handle_t *ifofile) {
   if(!ifofile)
     return;
 
-  if(ifofile->vts_atrt) {
-    free(ifofile->vts_atrt->vts);
-    free(ifofile->vts_atrt->vts_atrt_offsets);
-    free(ifofile->vts_atrt);
-    ifofile->vts_atrt = 0;
-  }
+  ifofile->vts_atrt = 0;
 }
 
 
@@ -2177,24 +1986,21 @@ int ifoRead_TXTDT_MGI(ifo_handle_t *ifofile) {
   if(ifofile->vmgi_mat->txtdt_mgi == 0)
     return 1;
 
-  if(!DVDFileSeek_(ifofile->file,
+  if(!ifoSeek(ifofile,
 		   ifofile->vmgi_mat->txtdt_mgi * DVD_BLOCK_LEN))
     return 0;
 
-  txtdt_mgi = (txtdt_mgi_t *)malloc(sizeof(txtdt_mgi_t));
-  if(!txtdt_mgi) {
+  txtdt_mgi = (txtdt_mgi_t *)ifoAlloc(ifofile, sizeof(txtdt_mgi_t));
+  if(!txtdt_mgi)
     return 0;
-  }
-  ifofile->txtdt_mgi = txtdt_mgi;
 
-  if(!(DVDReadBytes(ifofile->file, txtdt_mgi, TXTDT_MGI_SIZE))) {
+  if(!(ifoReadBytes(ifofile, txtdt_mgi, TXTDT_MGI_SIZE))) {
     fprintf(stderr, "libdvdread: Unable to read TXTDT_MGI.\n");
-    free(txtdt_mgi);
-    ifofile->txtdt_mgi = 0;
     return 0;
   }
 
   /* fprintf(stderr, "-- Not done yet --\n"); */
+  ifofile->txtdt_mgi = txtdt_mgi;
   return 1;
 }
 
@@ -2202,9 +2008,110 @@ void ifoFree_TXTDT_MGI(ifo_handle_t *ifofile) {
   if(!ifofile)
     return;
 
-  if(ifofile->txtdt_mgi) {
-    free(ifofile->txtdt_mgi);
-    ifofile->txtdt_mgi = 0;
-  }
+  ifofile->txtdt_mgi = 0;
+}
+
+
+
+/* Tables read in on demand, for ifo_handle_t.tables_failed */
+#define IFO_TABLE_PGCI_UT           0x001
+#define IFO_TABLE_PTL_MAIT          0x002
+#define IFO_TABLE_VTS_ATRT          0x004
+#define IFO_TABLE_TXTDT_MGI         0x008
+#define IFO_TABLE_VTS_TMAPT         0x010
+#define IFO_TABLE_C_ADT             0x020
+#define IFO_TABLE_TITLE_C_ADT       0x040
+#define IFO_TABLE_VOBU_ADMAP        0x080
+#define IFO_TABLE_TITLE_VOBU_ADMAP  0x100
+
+/* Reads a table in, unless it is there already or failed before. A table
+ * the IFO doesn't have reads as success and stays NULL. */
+static void ifoLoad_table(ifo_handle_t *ifofile, void *table, uint32_t bit,
+                          int (*read_table)(ifo_handle_t *)) {
+  if(table || (ifofile->tables_failed & bit))
+    return;
+
+  if(!read_table(ifofile))
+    ifofile->tables_failed |= bit;
+}
+
+pgci_ut_t *ifoGet_PGCI_UT(ifo_handle_t *ifofile) {
+  if(!ifofile)
+    return NULL;
+
+  ifoLoad_table(ifofile, ifofile->pgci_ut, IFO_TABLE_PGCI_UT,
+                ifoRead_PGCI_UT);
+  return ifofile->pgci_ut;
+}
+
+ptl_mait_t *ifoGet_PTL_MAIT(ifo_handle_t *ifofile) {
+  if(!ifofile)
+    return NULL;
+
+  ifoLoad_table(ifofile, ifofile->ptl_mait, IFO_TABLE_PTL_MAIT,
+                ifoRead_PTL_MAIT);
+  return ifofile->ptl_mait;
+}
+
+vts_atrt_t *ifoGet_VTS_ATRT(ifo_handle_t *ifofile) {
+  if(!ifofile)
+    return NULL;
+
+  ifoLoad_table(ifofile, ifofile->vts_atrt, IFO_TABLE_VTS_ATRT,
+                ifoRead_VTS_ATRT);
+  return ifofile->vts_atrt;
+}
+
+txtdt_mgi_t *ifoGet_TXTDT_MGI(ifo_handle_t *ifofile) {
+  if(!ifofile)
+    return NULL;
+
+  ifoLoad_table(ifofile, ifofile->txtdt_mgi, IFO_TABLE_TXTDT_MGI,
+                ifoRead_TXTDT_MGI);
+  return ifofile->txtdt_mgi;
+}
+
+vts_tmapt_t *ifoGet_VTS_TMAPT(ifo_handle_t *ifofile) {
+  if(!ifofile)
+    return NULL;
+
+  ifoLoad_table(ifofile, ifofile->vts_tmapt, IFO_TABLE_VTS_TMAPT,
+                ifoRead_VTS_TMAPT);
+  return ifofile->vts_tmapt;
 }
 
+c_adt_t *ifoGet_C_ADT(ifo_handle_t *ifofile) {
+  if(!ifofile)
+    return NULL;
+
+  ifoLoad_table(ifofile, ifofile->menu_c_adt, IFO_TABLE_C_ADT,
+                ifoRead_C_ADT);
+  return ifofile->menu_c_adt;
+}
+
+c_adt_t *ifoGet_TITLE_C_ADT(ifo_handle_t *ifofile) {
+  if(!ifofile)
+    return NULL;
+
+  ifoLoad_table(ifofile, ifofile->vts_c_adt, IFO_TABLE_TITLE_C_ADT,
+                ifoRead_TITLE_C_ADT);
+  return ifofile->vts_c_adt;
+}
+
+vobu_admap_t *ifoGet_VOBU_ADMAP(ifo_handle_t *ifofile) {
+  if(!ifofile)
+    return NULL;
+
+  ifoLoad_table(ifofile, ifofile->menu_vobu_admap, IFO_TABLE_VOBU_ADMAP,
+                ifoRead_VOBU_ADMAP);
+  return ifofile->menu_vobu_admap;
+}
+
+vobu_admap_t *ifoGet_TITLE_VOBU_ADMAP(ifo_handle_t *ifofile) {
+  if(!ifofile)
+    return NULL;
+
+  ifoLoad_table(ifofile, ifofile->vts_vobu_admap, IFO_TABLE_TITLE_VOBU_ADMAP,
+                ifoRead_TITLE_VOBU_ADMAP);
+  return ifofile->vts_vobu_admap;
+}
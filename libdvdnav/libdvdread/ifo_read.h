@@ -30,9 +30,11 @@ extern "C" {
 /**
  * handle = ifoOpen(dvd, title);
  *
- * Opens an IFO and reads in all the data for the IFO file corresponding to the
- * given title.  If title 0 is given, the video manager IFO file is read.
- * Returns a handle to a completely parsed structure.
+ * Opens an IFO and reads in the mandatory data for the IFO file corresponding
+ * to the given title.  If title 0 is given, the video manager IFO file is
+ * read.  The other tables are read in on demand through the ifoGet_* calls
+ * below.  The IFO file itself is read in whole, in a single request, and
+ * kept with the handle, the tables are parsed from memory.
  */
 ifo_handle_t *ifoOpen(dvd_reader_t *, int );
 
@@ -57,7 +59,8 @@ ifo_handle_t *ifoOpenVTSI(dvd_reader_t *, int);
 /**
  * ifoClose(ifofile);
  * Cleans up the IFO information.  This will free all data allocated for the
- * substructures.
+ * substructures.  The handle and all of its tables share one arena, so this
+ * is normally a single free.
  */
 void ifoClose(ifo_handle_t *);
 
@@ -202,8 +205,27 @@ int ifoRead_TITLE_VOBU_ADMAP(ifo_handle_t *);
 int ifoRead_TXTDT_MGI(ifo_handle_t *);
 
 /**
- * The following functions are used for freeing parsed sections of the
- * ifo_handle_t structure and the allocated substructures.  The free calls
+ * table = ifoGet_PGCI_UT(ifofile);
+ *
+ * The following functions return a table of the IFO, reading it in with the
+ * matching ifoRead_* call the first time it is asked for.  They return NULL
+ * if the IFO has no such table or it could not be read, a table that failed
+ * to read is not tried again.  The table belongs to the handle.
+ */
+pgci_ut_t *ifoGet_PGCI_UT(ifo_handle_t *);
+ptl_mait_t *ifoGet_PTL_MAIT(ifo_handle_t *);
+vts_atrt_t *ifoGet_VTS_ATRT(ifo_handle_t *);
+txtdt_mgi_t *ifoGet_TXTDT_MGI(ifo_handle_t *);
+vts_tmapt_t *ifoGet_VTS_TMAPT(ifo_handle_t *);
+c_adt_t *ifoGet_C_ADT(ifo_handle_t *);
+c_adt_t *ifoGet_TITLE_C_ADT(ifo_handle_t *);
+vobu_admap_t *ifoGet_VOBU_ADMAP(ifo_handle_t *);
+vobu_admap_t *ifoGet_TITLE_VOBU_ADMAP(ifo_handle_t *);
+
+/**
+ * The following functions are used for dropping parsed sections of the
+ * ifo_handle_t structure.  Their memory is only given back by ifoClose(),
+ * reading a section in again after dropping it takes more.  The free calls
  * below are safe:  they will not mind if you attempt to free part of an IFO
  * file which was not read in or which does not exist.
  */
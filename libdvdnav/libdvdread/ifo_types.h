@@ -720,7 +720,15 @@ typedef struct {
  * is read in from the VTS_XX_0.[IFO,BUP] files.
  */
 typedef struct {
-  dvd_file_t *file;
+  /* The whole IFO file, the tables are parsed from it */
+  uint8_t        *image;
+  uint32_t        image_size;
+  uint32_t        image_pos;
+
+  /* Arena the handle and all of its tables are allocated from */
+  void           *arena;
+  uint8_t        *arena_next;
+  uint32_t        arena_left;
 
   /* VMGI */
   vmgi_mat_t     *vmgi_mat;
@@ -742,6 +750,9 @@ typedef struct {
   vts_tmapt_t    *vts_tmapt;
   c_adt_t        *vts_c_adt;
   vobu_admap_t   *vts_vobu_admap;
+
+  /* Tables the ifoGet_* calls failed to read, they are not tried again */
+  uint32_t        tables_failed;
 } ifo_handle_t;
 
 #endif /* IFO_TYPES_H_INCLUDED */
@@ -213,18 +213,8 @@ static int ifoOpenNewVTSI(vm_t *vm, dvd_reader_t *dvd, int vtsN) {
     fprintf(MSG_OUT, "libdvdnav: ifoRead_PGCIT failed\n");
     return 0;
   }
-  if(!ifoRead_PGCI_UT(vm->vtsi)) {
-    fprintf(MSG_OUT, "libdvdnav: ifoRead_PGCI_UT failed\n");
-    return 0;
-  }
-  if(!ifoRead_VOBU_ADMAP(vm->vtsi)) {
-    fprintf(MSG_OUT, "libdvdnav: ifoRead_VOBU_ADMAP vtsi failed\n");
-    return 0;
-  }
-  if(!ifoRead_TITLE_VOBU_ADMAP(vm->vtsi)) {
-    fprintf(MSG_OUT, "libdvdnav: ifoRead_TITLE_VOBU_ADMAP vtsi failed\n");
-    return 0;
-  }
+  /* The menu PGCI unit table and the address maps are read in when first
+   * used, through ifoGet_PGCI_UT() and ifoGet_*VOBU_ADMAP() */
   (vm->state).vtsN = vtsN;
 
   return 1;
@@ -345,22 +335,9 @@ int vm_reset(vm_t *vm, const char *dvdroot) {
       fprintf(MSG_OUT, "libdvdnav: vm: ifoRead_TT_SRPT failed\n");
       return 0;
     }
-    if(!ifoRead_PGCI_UT(vm->vmgi)) {
-      fprintf(MSG_OUT, "libdvdnav: vm: ifoRead_PGCI_UT failed\n");
-      return 0;
-    }
-    if(!ifoRead_PTL_MAIT(vm->vmgi)) {
-      fprintf(MSG_OUT, "libdvdnav: vm: ifoRead_PTL_MAIT failed\n");
-      /* return 0; Not really used for now.. */
-    }
-    if(!ifoRead_VTS_ATRT(vm->vmgi)) {
-      fprintf(MSG_OUT, "libdvdnav: vm: ifoRead_VTS_ATRT failed\n");
-      /* return 0; Not really used for now.. */
-    }
-    if(!ifoRead_VOBU_ADMAP(vm->vmgi)) {
-      fprintf(MSG_OUT, "libdvdnav: vm: ifoRead_VOBU_ADMAP vgmi failed\n");
-      /* return 0; Not really used for now.. */
-    }
+    /* The menu PGCI unit table is optional, get_MENU_PGCIT() reads it in
+     * on demand.  PTL_MAIT, VTS_ATRT and the VOBU_ADMAP are not really used
+     * for now, they are read in on demand through the ifoGet_* calls. */
     /* ifoRead_TXTDT_MGI(vmgi); Not implemented yet */
   }
   if (vm->vmgi) {
@@ -1795,31 +1772,33 @@ static int get_PGCN(vm_t *vm) {
 static pgcit_t* get_MENU_PGCIT(vm_t *vm, ifo_handle_t *h, uint16_t lang) {
   int i;
 
-  if(h == NULL || h->pgci_ut == NULL) {
+  pgci_ut_t *pgci_ut = ifoGet_PGCI_UT(h);
+
+  if(pgci_ut == NULL) {
     fprintf(MSG_OUT, "libdvdnav: *** pgci_ut handle is NULL ***\n");
     return NULL; /*  error? */
   }
 
   i = 0;
-  while(i < h->pgci_ut->nr_of_lus
-	&& h->pgci_ut->lu[i].lang_code != lang)
+  while(i < pgci_ut->nr_of_lus
+	&& pgci_ut->lu[i].lang_code != lang)
     i++;
-  if(i == h->pgci_ut->nr_of_lus) {
+  if(i == pgci_ut->nr_of_lus) {
     fprintf(MSG_OUT, "libdvdnav: Language '%c%c' not found, using '%c%c' instead\n",
 	    (char)(lang >> 8), (char)(lang & 0xff),
- 	    (char)(h->pgci_ut->lu[0].lang_code >> 8),
-	    (char)(h->pgci_ut->lu[0].lang_code & 0xff));
+ 	    (char)(pgci_ut->lu[0].lang_code >> 8),
+	    (char)(pgci_ut->lu[0].lang_code & 0xff));
     fprintf(MSG_OUT, "libdvdnav: Menu Languages available: ");
-    for(i = 0; i < h->pgci_ut->nr_of_lus; i++) {
+    for(i = 0; i < pgci_ut->nr_of_lus; i++) {
       fprintf(MSG_OUT, "%c%c ",
- 	    (char)(h->pgci_ut->lu[i].lang_code >> 8),
-	    (char)(h->pgci_ut->lu[i].lang_code & 0xff));
+ 	    (char)(pgci_ut->lu[i].lang_code >> 8),
+	    (char)(pgci_ut->lu[i].lang_code & 0xff));
     }
     fprintf(MSG_OUT, "\n");
     i = 0; /*  error? */
   }
 
-  return h->pgci_ut->lu[i].pgcit;
+  return pgci_ut->lu[i].pgcit;
 }
 
 /* Uses state to decide what to return */
@@ -22,9 +22,16 @@
  *
  */
 /*
- * There was a multithreaded read ahead cache in here for some time, but
- * it had only been used for a short time. If you want to have a look at it,
- * search the CVS attic.
+ * The read-ahead is done by a few background threads (see _MULTITHREAD_ in
+ * read_cache.h). dvdnav_pre_cache_blocks() queues chunks for the next VOBU
+ * and, during sequential playback, for the ones after it. Each thread takes
+ * the oldest queued chunk nobody else is filling and fills it in steps of
+ * read_ahead_size sectors, so several reads are in flight at once, while
+ * dvdnav_read_cache_block() hands out the sectors that have already arrived
+ * and only blocks when it overtakes the threads.
+ *
+ * Blocks of a memory mapped image are handed out straight from the mapping
+ * and never pass through the cache.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -32,7 +39,9 @@
 #endif
 
 #include <inttypes.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <limits.h>
 #include <sys/time.h>
 #include <time.h>
@@ -46,7 +55,14 @@
 #include "dvdnav_internal.h"
 #include "read_cache.h"
 
-#define READ_CACHE_CHUNKS 10
+/* The cache is one arena, allocated in a single piece the first time the
+ * read-ahead is used and never grown, which is cut into equally sized slabs.
+ * Each slab holds the sectors of one VOBU. */
+#define READ_CACHE_CHUNKS_MAX     16
+#define READ_CACHE_CHUNKS_MIN     2
+/* A VOBU holds at most one second of a 10.08 Mbit/s stream, ~615 blocks. */
+#define READ_CACHE_CHUNK_BLOCKS   640
+#define READ_CACHE_SIZE           (8 * READ_CACHE_CHUNK_BLOCKS * DVD_VIDEO_LB_LEN)
 
 /* all cache chunks must be memory aligned to allow use of raw devices */
 #define ALIGNMENT 2048
@@ -54,19 +70,39 @@
 #define READ_AHEAD_SIZE_MIN 4
 #define READ_AHEAD_SIZE_MAX 512
 
+/* read-ahead threads, i.e. the number of reads kept in flight */
+#define READ_CACHE_FILLERS  3
+/* VOBUs queued beyond the one announced by the NAV packet */
+#define READ_CACHE_PREFETCH 2
+
+/* Chunks are found through a small hash index keyed by (file, sector)
+ * instead of scanning them. Each bucket covers a span of sectors and holds
+ * a bit mask of the chunks overlapping that span, so a lookup only has to
+ * check the one or two chunks named in its bucket. The owner of a block
+ * handed out by the cache follows from its offset into the arena. */
+#define READ_CACHE_INDEX_SIZE  256  /* buckets, power of two */
+#define READ_CACHE_SECTOR_SPAN 6    /* log2 of the sectors per bucket */
+
+typedef uint16_t read_cache_mask_t; /* needs a bit per chunk */
+#if READ_CACHE_CHUNKS_MAX > 16
+#error "read_cache_mask_t is too small for READ_CACHE_CHUNKS_MAX"
+#endif
+
 typedef struct read_cache_chunk_s {
-  uint8_t     *cache_buffer;
-  uint8_t     *cache_buffer_base;  /* used in malloc and free for alignment */
+  uint8_t     *cache_buffer;       /* this chunk's slab of the arena */
+  dvd_file_t  *cache_file;         /* file the sectors are read from */
   int32_t      cache_start_sector; /* -1 means cache invalid */
   int32_t      cache_read_count;   /* this many sectors are already read */
   size_t       cache_block_count;  /* this many sectors will go in this chunk */
-  size_t       cache_malloc_size;
   int          cache_valid;
   int          usage_count;  /* counts how many buffers where issued from this chunk */
+  uint32_t     generation;   /* bumped whenever the chunk is retargeted or invalidated */
+  uint32_t     order;        /* position in the read-ahead queue */
+  int          filling;      /* a read into this chunk is in flight */
 } read_cache_chunk_t;
 
 struct read_cache_s {
-  read_cache_chunk_t  chunk[READ_CACHE_CHUNKS];
+  read_cache_chunk_t  chunk[READ_CACHE_CHUNKS_MAX];
   int                 current;
   int                 freeing;  /* is set to one when we are about to dispose the cache */
   uint32_t            read_ahead_size;
@@ -74,6 +110,31 @@ struct read_cache_s {
   int                 last_sector;
   pthread_mutex_t     lock;
 
+  /* arena */
+  uint8_t            *arena;
+  uint8_t            *arena_base;   /* used in malloc and free for alignment */
+  size_t              max_bytes;    /* upper bound for the arena */
+  size_t              chunk_blocks; /* sectors per slab */
+  int                 chunk_count;  /* slabs in the arena */
+  int                 usage_count;  /* buffers handed out and not yet returned */
+
+  dvdnav_cache_stats_t stats;   /* counters, read_ahead_size and chunks are filled in on demand */
+
+  read_cache_mask_t   sector_index[READ_CACHE_INDEX_SIZE];
+
+  int                 filling;  /* reads in flight */
+  int                 wanted;   /* chunk a reader is blocked on, -1 if none */
+  uint32_t            next_order;
+  dvd_file_t         *precache_file; /* where the last pre-cached VOBU ended */
+  int32_t             precache_end;
+#if _MULTITHREAD_
+  pthread_t           thread[READ_CACHE_FILLERS];
+  pthread_cond_t      wakeup;   /* new work for the read-ahead threads */
+  pthread_cond_t      progress; /* a read-ahead thread finished a read */
+  int                 thread_count;
+  int                 quit;
+#endif
+
   /* Bit of strange cross-linking going on here :) -- Gotta love C :) */
   dvdnav_t           *dvd_self;
 };
@@ -101,6 +162,210 @@ struct read_cache_s {
 #endif
 
 
+static uintptr_t read_cache_file_salt(dvd_file_t *file) {
+  return (uintptr_t)file >> 4;
+}
+
+/* Sets or clears the bit of 'chunk' in every bucket covering its sectors. */
+static void read_cache_index_sectors(read_cache_t *self, int use, int set) {
+  read_cache_chunk_t *chunk = &self->chunk[use];
+  uintptr_t salt, key, end;
+
+  salt = read_cache_file_salt(chunk->cache_file);
+  key = (uintptr_t)chunk->cache_start_sector >> READ_CACHE_SECTOR_SPAN;
+  end = ((uintptr_t)chunk->cache_start_sector + chunk->cache_block_count - 1) >> READ_CACHE_SECTOR_SPAN;
+  if (end - key >= READ_CACHE_INDEX_SIZE)
+    end = key + READ_CACHE_INDEX_SIZE - 1;
+  for (; key <= end; key++) {
+    if (set)
+      self->sector_index[(key ^ salt) & (READ_CACHE_INDEX_SIZE - 1)] |= (read_cache_mask_t)(1 << use);
+    else
+      self->sector_index[(key ^ salt) & (READ_CACHE_INDEX_SIZE - 1)] &= (read_cache_mask_t)~(1 << use);
+  }
+}
+
+/* Drops a chunk's sectors from the cache. Must be called with self->lock held. */
+static void read_cache_invalidate(read_cache_t *self, int use) {
+  if (self->chunk[use].cache_valid)
+    read_cache_index_sectors(self, use, 0);
+  self->chunk[use].cache_valid = 0;
+  self->chunk[use].generation++;
+}
+
+/* Returns the chunk that holds (or will hold) the sectors
+ * [sector, sector + block_count) of file, -1 if there is none.
+ * Must be called with self->lock held. */
+static int read_cache_find_sector(read_cache_t *self, dvd_file_t *file,
+                                  int sector, size_t block_count) {
+  read_cache_mask_t mask;
+  int i;
+
+  mask = self->sector_index[((sector >> READ_CACHE_SECTOR_SPAN) ^ read_cache_file_salt(file)) &
+                            (READ_CACHE_INDEX_SIZE - 1)];
+  for (i = 0; mask; i++, mask >>= 1)
+    if ((mask & 1) && self->chunk[i].cache_valid && self->chunk[i].cache_file == file &&
+        sector >= self->chunk[i].cache_start_sector &&
+        sector + block_count <= self->chunk[i].cache_start_sector + self->chunk[i].cache_block_count)
+      return i;
+  return -1;
+}
+
+/* Returns the chunk whose slab contains buf, -1 if there is none.
+ * Must be called with self->lock held. */
+static int read_cache_find_buffer(read_cache_t *self, uint8_t *buf) {
+  if (!self->arena || buf < self->arena ||
+      buf >= self->arena + self->chunk_count * self->chunk_blocks * DVD_VIDEO_LB_LEN)
+    return -1;
+  return (buf - self->arena) / (self->chunk_blocks * DVD_VIDEO_LB_LEN);
+}
+
+/* Returns the microseconds since 'start'. */
+static uint64_t read_cache_elapsed(struct timeval *start) {
+  struct timeval now;
+
+  gettimeofday(&now, NULL);
+  return (uint64_t)(now.tv_sec - start->tv_sec) * 1000000 + (now.tv_usec - start->tv_usec);
+}
+
+/* Accounts a DVDReadBlocks() call. Must be called with self->lock held. */
+static void read_cache_count_read(read_cache_t *self, ssize_t res, struct timeval *start) {
+  self->stats.read_calls++;
+  self->stats.read_time += read_cache_elapsed(start);
+  if (res > 0)
+    self->stats.bytes_read += (uint64_t)res * DVD_VIDEO_LB_LEN;
+}
+
+/* Allocates the arena and cuts it into slabs. Must be called with self->lock held. */
+static int read_cache_alloc_arena(read_cache_t *self) {
+  size_t slab_size;
+  int i;
+
+  slab_size = self->chunk_blocks * DVD_VIDEO_LB_LEN;
+  self->chunk_count = self->max_bytes / slab_size;
+  if (self->chunk_count > READ_CACHE_CHUNKS_MAX)
+    self->chunk_count = READ_CACHE_CHUNKS_MAX;
+  if (self->chunk_count < READ_CACHE_CHUNKS_MIN)
+    self->chunk_count = READ_CACHE_CHUNKS_MIN;
+
+  self->arena_base = malloc(self->chunk_count * slab_size + ALIGNMENT);
+  if (!self->arena_base) {
+    self->chunk_count = 0;
+    return 0;
+  }
+  self->arena =
+    (uint8_t *)(((uintptr_t)self->arena_base & ~((uintptr_t)(ALIGNMENT - 1))) + ALIGNMENT);
+  for (i = 0; i < self->chunk_count; i++)
+    self->chunk[i].cache_buffer = self->arena + i * slab_size;
+  self->stats.arena_allocs++;
+  dprintf("pre_cache DVD read malloc %d chunks of %d blocks\n",
+    self->chunk_count, (int)self->chunk_blocks);
+
+  return 1;
+}
+
+/* Releases the arena. Must be called with self->lock held and no buffers out. */
+static void read_cache_free_arena(read_cache_t *self) {
+  int i;
+
+  for (i = 0; i < READ_CACHE_CHUNKS_MAX; i++) {
+    read_cache_invalidate(self, i);
+    self->chunk[i].cache_buffer = NULL;
+  }
+  free(self->arena_base);
+  self->arena_base = NULL;
+  self->arena = NULL;
+  self->chunk_count = 0;
+}
+
+/* Returns whether chunk 'use' still has sectors to read that nobody is
+ * reading. Must be called with self->lock held. */
+static int read_cache_needs_fill(read_cache_t *self, int use) {
+  read_cache_chunk_t *chunk = &self->chunk[use];
+
+  return chunk->cache_valid && chunk->cache_buffer && !chunk->filling &&
+         chunk->cache_read_count < (int32_t)chunk->cache_block_count;
+}
+
+/* Returns the chunk the read-ahead should fill next, -1 if there is none:
+ * the one a reader waits for, else the one queued first.
+ * Must be called with self->lock held. */
+static int read_cache_next_fill(read_cache_t *self) {
+  int i, best;
+
+  if (self->wanted >= 0 && read_cache_needs_fill(self, self->wanted))
+    return self->wanted;
+  best = -1;
+  for (i = 0; i < self->chunk_count; i++)
+    if (read_cache_needs_fill(self, i) &&
+        (best < 0 || (int32_t)(self->chunk[i].order - self->chunk[best].order) < 0))
+      best = i;
+  return best;
+}
+
+/* Reads the next read_ahead_size sectors into chunk 'use'.
+ * Must be called with self->lock held, the lock is dropped during the read. */
+static void read_cache_fill(read_cache_t *self, int use) {
+  read_cache_chunk_t *chunk = &self->chunk[use];
+  dvd_file_t *file;
+  uint8_t *dest;
+  uint32_t generation;
+  int32_t start;
+  size_t size;
+  ssize_t res;
+  struct timeval tv;
+
+  size = chunk->cache_block_count - chunk->cache_read_count;
+  if (size > self->read_ahead_size)
+    size = self->read_ahead_size;
+  start = chunk->cache_start_sector + chunk->cache_read_count;
+  dest = chunk->cache_buffer + chunk->cache_read_count * DVD_VIDEO_LB_LEN;
+  generation = chunk->generation;
+  file = chunk->cache_file;
+  chunk->filling = 1;
+  self->filling++;
+  pthread_mutex_unlock(&self->lock);
+
+  dprintf("read_ahead_size=%d, start=%d, size=%d\n", self->read_ahead_size, start, (int)size);
+  gettimeofday(&tv, NULL);
+  res = file ? DVDReadBlocks(file, start, size, dest) : -1;
+
+  pthread_mutex_lock(&self->lock);
+  read_cache_count_read(self, res, &tv);
+  chunk->filling = 0;
+  self->filling--;
+  /* the chunk may have been invalidated while we were reading */
+  if (chunk->cache_valid && chunk->generation == generation) {
+    if (res > 0) {
+      chunk->cache_read_count += res;
+    } else {
+      /* let the reader fall back to a direct read, which reports the error */
+      dprintf("read-ahead of sector %d failed\n", start);
+      read_cache_invalidate(self, use);
+    }
+  }
+}
+
+#if _MULTITHREAD_
+static void *read_cache_thread(void *data) {
+  read_cache_t *self = (read_cache_t *)data;
+  int use;
+
+  pthread_mutex_lock(&self->lock);
+  while (!self->quit) {
+    use = read_cache_next_fill(self);
+    if (use < 0) {
+      pthread_cond_wait(&self->wakeup, &self->lock);
+      continue;
+    }
+    read_cache_fill(self, use);
+    pthread_cond_broadcast(&self->progress);
+  }
+  pthread_mutex_unlock(&self->lock);
+
+  return NULL;
+}
+#endif
+
 read_cache_t *dvdnav_read_cache_new(dvdnav_t* dvd_self) {
   read_cache_t *self;
   int i;
@@ -114,12 +379,38 @@ read_cache_t *dvdnav_read_cache_new(dvdnav_t* dvd_self) {
     self->last_sector = 0;
     self->read_ahead_size = READ_AHEAD_SIZE_MIN;
     self->read_ahead_incr = 0;
+    self->filling = 0;
+    self->wanted = -1;
+    self->next_order = 0;
+    self->precache_file = NULL;
+    self->precache_end = -1;
     pthread_mutex_init(&self->lock, NULL);
-    dvdnav_read_cache_clear(self);
-    for (i = 0; i < READ_CACHE_CHUNKS; i++) {
+    self->arena = NULL;
+    self->arena_base = NULL;
+    self->max_bytes = READ_CACHE_SIZE;
+    self->chunk_blocks = READ_CACHE_CHUNK_BLOCKS;
+    self->chunk_count = 0;
+    self->usage_count = 0;
+    memset(&self->stats, 0, sizeof(self->stats));
+    for (i = 0; i < READ_CACHE_CHUNKS_MAX; i++) {
       self->chunk[i].cache_buffer = NULL;
+      self->chunk[i].cache_valid = 0;
       self->chunk[i].usage_count = 0;
+      self->chunk[i].generation = 0;
+      self->chunk[i].order = 0;
+      self->chunk[i].filling = 0;
     }
+    memset(self->sector_index, 0, sizeof(self->sector_index));
+#if _MULTITHREAD_
+    pthread_cond_init(&self->wakeup, NULL);
+    pthread_cond_init(&self->progress, NULL);
+    self->quit = 0;
+    for (self->thread_count = 0; self->thread_count < READ_CACHE_FILLERS; self->thread_count++)
+      if (pthread_create(&self->thread[self->thread_count], NULL, read_cache_thread, self) != 0)
+        break;
+    if (!self->thread_count)
+      fprintf(MSG_OUT, "libdvdnav: unable to start read-ahead thread, reading synchronously\n");
+#endif
   }
 
   return self;
@@ -127,28 +418,70 @@ read_cache_t *dvdnav_read_cache_new(dvdnav_t* dvd_self) {
 
 void dvdnav_read_cache_free(read_cache_t* self) {
   dvdnav_t *tmp;
-  int i;
 
   pthread_mutex_lock(&self->lock);
   self->freeing = 1;
-  for (i = 0; i < READ_CACHE_CHUNKS; i++)
-    if (self->chunk[i].cache_buffer && self->chunk[i].usage_count == 0) {
-      free(self->chunk[i].cache_buffer_base);
-      self->chunk[i].cache_buffer = NULL;
-    }
-  pthread_mutex_unlock(&self->lock);
+#if _MULTITHREAD_
+  if (self->thread_count) {
+    int i, count = self->thread_count;
 
-  for (i = 0; i < READ_CACHE_CHUNKS; i++)
-    if (self->chunk[i].cache_buffer) return;
+    self->quit = 1;
+    self->thread_count = 0;
+    pthread_cond_broadcast(&self->wakeup);
+    pthread_mutex_unlock(&self->lock);
+    for (i = 0; i < count; i++)
+      pthread_join(self->thread[i], NULL);
+    pthread_mutex_lock(&self->lock);
+  }
+#endif
+  if (self->usage_count) {
+    /* buffers are still out, the last dvdnav_free_cache_block() frees us */
+    pthread_mutex_unlock(&self->lock);
+    return;
+  }
+  read_cache_free_arena(self);
+  pthread_mutex_unlock(&self->lock);
 
   /* all buffers returned, free everything */
   tmp = self->dvd_self;
+#if _MULTITHREAD_
+  pthread_cond_destroy(&self->wakeup);
+  pthread_cond_destroy(&self->progress);
+#endif
   pthread_mutex_destroy(&self->lock);
   free(self);
   free(tmp);
 }
 
-/* This function MUST be called whenever self->file changes. */
+int dvdnav_read_cache_configure(read_cache_t *self, size_t max_bytes, size_t chunk_blocks) {
+  if(!self)
+    return 0;
+
+  if (chunk_blocks == 0)
+    chunk_blocks = READ_CACHE_CHUNK_BLOCKS;
+  if (max_bytes == 0)
+    max_bytes = READ_CACHE_SIZE;
+
+  pthread_mutex_lock(&self->lock);
+  if (self->usage_count) {
+    pthread_mutex_unlock(&self->lock);
+    return 0;
+  }
+#if _MULTITHREAD_
+  while (self->filling)
+    pthread_cond_wait(&self->progress, &self->lock);
+#endif
+  /* the arena is set up again with the new layout on its next use */
+  read_cache_free_arena(self);
+  self->max_bytes = max_bytes;
+  self->chunk_blocks = chunk_blocks;
+  pthread_mutex_unlock(&self->lock);
+
+  return 1;
+}
+
+/* This function MUST be called whenever self->file changes,
+ * and before the old file is closed. */
 void dvdnav_read_cache_clear(read_cache_t *self) {
   int i;
 
@@ -156,14 +489,37 @@ void dvdnav_read_cache_clear(read_cache_t *self) {
    return;
 
   pthread_mutex_lock(&self->lock);
-  for (i = 0; i < READ_CACHE_CHUNKS; i++)
-    self->chunk[i].cache_valid = 0;
+  for (i = 0; i < self->chunk_count; i++)
+    read_cache_invalidate(self, i);
+#if _MULTITHREAD_
+  /* the read-ahead threads must be done with the file before it goes away */
+  while (self->filling)
+    pthread_cond_wait(&self->progress, &self->lock);
+#endif
   pthread_mutex_unlock(&self->lock);
 }
 
+/* Returns the slab to reuse next, -1 if all are in use. Slabs are taken
+ * round-robin after the last one queued, so the oldest goes first.
+ * Must be called with self->lock held. */
+static int read_cache_alloc_chunk(read_cache_t *self) {
+  int i;
+
+  for (i = 1; i <= self->chunk_count; i++) {
+    int candidate = (self->current + i) % self->chunk_count;
+
+    if (self->chunk[candidate].usage_count == 0 && !self->chunk[candidate].filling)
+      return candidate;
+  }
+  return -1;
+}
+
 /* This function is called just after reading the NAV packet. */
 void dvdnav_pre_cache_blocks(read_cache_t *self, int sector, size_t block_count) {
-  int i, use;
+  dvd_file_t *file;
+  int32_t end, window_end;
+  size_t count;
+  int use, queued;
 
   if(!self)
     return;
@@ -171,166 +527,225 @@ void dvdnav_pre_cache_blocks(read_cache_t *self, int sector, size_t block_count)
   if(!self->dvd_self->use_read_ahead)
     return;
 
+  file = self->dvd_self->file;
+  end = sector + block_count;
+  window_end = end;
+  /* During sequential playback the following VOBUs are queued as well,
+   * guessing that they are about as long as this one. */
+  if (file == self->precache_file && sector == self->precache_end)
+    window_end += READ_CACHE_PREFETCH * block_count;
+  self->precache_file = file;
+  self->precache_end = end;
+
+  /* a memory mapped image needs no copy in the cache, just let the
+   * kernel page in the VOBUs ahead of time */
+  if (DVDMapBlocks(file, sector, block_count)) {
+    DVDAdviseBlocks(file, sector, window_end - sector);
+    return;
+  }
+
   pthread_mutex_lock(&self->lock);
 
-  /* find a free cache chunk that best fits the required size */
-  use = -1;
-  for (i = 0; i < READ_CACHE_CHUNKS; i++)
-    if (self->chunk[i].usage_count == 0 && self->chunk[i].cache_buffer &&
-        self->chunk[i].cache_malloc_size >= block_count &&
-        (use == -1 || self->chunk[use].cache_malloc_size > self->chunk[i].cache_malloc_size))
-      use = i;
-
-  if (use == -1) {
-    /* we haven't found a cache chunk, so we try to reallocate an existing one */
-    for (i = 0; i < READ_CACHE_CHUNKS; i++)
-      if (self->chunk[i].usage_count == 0 && self->chunk[i].cache_buffer &&
-          (use == -1 || self->chunk[use].cache_malloc_size < self->chunk[i].cache_malloc_size))
-        use = i;
+  if (!self->arena && !read_cache_alloc_arena(self)) {
+    dprintf("pre_caching was impossible, no memory for the cache\n");
+    pthread_mutex_unlock(&self->lock);
+    return;
+  }
+
+  /* Queue slabs for the parts of the window that are not cached yet. At most
+   * half of the slabs are taken, the others may still be read from. */
+  queued = 0;
+  while (sector < window_end && queued < self->chunk_count / 2) {
+    use = read_cache_find_sector(self, file, sector, 1);
     if (use >= 0) {
-      self->chunk[use].cache_buffer_base = realloc(self->chunk[use].cache_buffer_base,
-        block_count * DVD_VIDEO_LB_LEN + ALIGNMENT);
-      self->chunk[use].cache_buffer =
-        (uint8_t *)(((uintptr_t)self->chunk[use].cache_buffer_base & ~((uintptr_t)(ALIGNMENT - 1))) + ALIGNMENT);
-      dprintf("pre_cache DVD read realloc happened\n");
-      self->chunk[use].cache_malloc_size = block_count;
-    } else {
-      /* we still haven't found a cache chunk, let's allocate a new one */
-      for (i = 0; i < READ_CACHE_CHUNKS; i++)
-        if (!self->chunk[i].cache_buffer) {
-	  use = i;
-	  break;
-	}
-      if (use >= 0) {
-        /* We start with a sensible figure for the first malloc of 500 blocks.
-         * Some DVDs I have seen venture to 450 blocks.
-         * This is so that fewer realloc's happen if at all.
-         */
-	self->chunk[i].cache_buffer_base =
-	  malloc((block_count > 500 ? block_count : 500) * DVD_VIDEO_LB_LEN + ALIGNMENT);
-	self->chunk[i].cache_buffer =
-	  (uint8_t *)(((uintptr_t)self->chunk[i].cache_buffer_base & ~((uintptr_t)(ALIGNMENT - 1))) + ALIGNMENT);
-	self->chunk[i].cache_malloc_size = block_count > 500 ? block_count : 500;
-	dprintf("pre_cache DVD read malloc %d blocks\n",
-	  (block_count > 500 ? block_count : 500 ));
-      }
+      sector = self->chunk[use].cache_start_sector + self->chunk[use].cache_block_count;
+      continue;
     }
-  }
 
-  if (use >= 0) {
+    use = read_cache_alloc_chunk(self);
+    if (use < 0) {
+      dprintf("pre_caching was impossible, no cache chunk available\n");
+      break;
+    }
+
+    count = window_end - sector;
+    if (count > self->chunk_blocks)
+      count = self->chunk_blocks;
+    read_cache_invalidate(self, use);
+    self->chunk[use].cache_file = file;
     self->chunk[use].cache_start_sector = sector;
-    self->chunk[use].cache_block_count = block_count;
+    self->chunk[use].cache_block_count = count;
     self->chunk[use].cache_read_count = 0;
     self->chunk[use].cache_valid = 1;
+    self->chunk[use].order = self->next_order++;
+    read_cache_index_sectors(self, use, 1);
     self->current = use;
-  } else {
-    dprintf("pre_caching was impossible, no cache chunk available\n");
+    sector += count;
+    queued++;
+#if _MULTITHREAD_
+    pthread_cond_signal(&self->wakeup);
+#endif
   }
   pthread_mutex_unlock(&self->lock);
 }
 
-int dvdnav_read_cache_block(read_cache_t *self, int sector, size_t block_count, uint8_t **buf) {
-  int i, use;
-  int start;
-  int size;
+/* Hands out at least min_count and at most max_count blocks starting at
+ * sector from the mapping or a cache chunk, without copying them.
+ * Returns the number of blocks, 0 if they are not cached. */
+static int read_cache_lookup(read_cache_t *self, int sector, size_t min_count,
+                             size_t max_count, uint8_t **buf) {
+  const unsigned char *mapped;
+  read_cache_chunk_t *chunk;
+  uint32_t generation;
+  int32_t avail;
+  int use;
   int incr;
-  uint8_t *read_ahead_buf;
-  int32_t res;
+  int waited;
+  struct timeval tv;
+
+  /* hand out blocks of a memory mapped image directly */
+  mapped = DVDMapBlocks(self->dvd_self->file, sector, max_count);
+  /* the span may run past the end of the file */
+  if (!mapped && max_count > min_count) {
+    mapped = DVDMapBlocks(self->dvd_self->file, sector, min_count);
+    if (mapped)
+      max_count = min_count;
+  }
+  if (mapped) {
+    pthread_mutex_lock(&self->lock);
+    self->stats.hits += max_count;
+    pthread_mutex_unlock(&self->lock);
+    *buf = (uint8_t *)mapped;
+    return max_count;
+  }
 
-  if(!self)
-    return 0;
+  pthread_mutex_lock(&self->lock);
 
-  use = -1;
+  use = read_cache_find_sector(self, self->dvd_self->file, sector, min_count);
+  if (use < 0) {
+    pthread_mutex_unlock(&self->lock);
+    return 0;
+  }
+  chunk = &self->chunk[use];
+  generation = chunk->generation;
 
-  if(self->dvd_self->use_read_ahead) {
-    /* first check, if sector is in current chunk */
-    read_cache_chunk_t cur = self->chunk[self->current];
-    if (cur.cache_valid && sector >= cur.cache_start_sector &&
-        sector <= (cur.cache_start_sector + cur.cache_read_count) &&
-        sector + block_count <= cur.cache_start_sector + cur.cache_block_count)
-      use = self->current;
-    else
-      for (i = 0; i < READ_CACHE_CHUNKS; i++)
-        if (self->chunk[i].cache_valid &&
-            sector >= self->chunk[i].cache_start_sector &&
-            sector <= (self->chunk[i].cache_start_sector + self->chunk[i].cache_read_count) &&
-            sector + block_count <= self->chunk[i].cache_start_sector + self->chunk[i].cache_block_count)
-            use = i;
+  /* Increment read-ahead size if sector follows the last sector */
+  if (sector == (self->last_sector + 1)) {
+    if (self->read_ahead_incr < READ_AHEAD_SIZE_MAX)
+      self->read_ahead_incr++;
+  } else {
+    self->read_ahead_size = READ_AHEAD_SIZE_MIN;
+    self->read_ahead_incr = 0;
   }
 
-  if (use >= 0) {
-    read_cache_chunk_t *chunk;
+  /* read_ahead_size */
+  incr = self->read_ahead_incr >> 1;
+  if ((self->read_ahead_size + incr) > READ_AHEAD_SIZE_MAX) {
+    self->read_ahead_size = READ_AHEAD_SIZE_MAX;
+  } else {
+    self->read_ahead_size += incr;
+  }
 
-    /* Increment read-ahead size if sector follows the last sector */
-    if (sector == (self->last_sector + 1)) {
-      if (self->read_ahead_incr < READ_AHEAD_SIZE_MAX)
-        self->read_ahead_incr++;
-    } else {
-      self->read_ahead_size = READ_AHEAD_SIZE_MIN;
-      self->read_ahead_incr = 0;
+  /* wait until the read-ahead has caught up with the wanted sectors */
+  gettimeofday(&tv, NULL);
+  waited = 0;
+  while (chunk->cache_valid && chunk->generation == generation &&
+         sector + min_count > chunk->cache_start_sector + chunk->cache_read_count) {
+    waited = 1;
+#if _MULTITHREAD_
+    if (self->thread_count) {
+      self->wanted = use;
+      pthread_cond_signal(&self->wakeup);
+      pthread_cond_wait(&self->progress, &self->lock);
+      continue;
     }
-    self->last_sector = sector;
+#endif
+    read_cache_fill(self, use);
+  }
+  if (waited)
+    self->stats.wait_time += read_cache_elapsed(&tv);
+  self->wanted = -1;
 
-    /* The following resources need to be protected by a mutex :
-     *   self->chunk[*].cache_buffer
-     *   self->chunk[*].cache_malloc_size
-     *   self->chunk[*].usage_count
-     */
-    pthread_mutex_lock(&self->lock);
-    chunk = &self->chunk[use];
-    read_ahead_buf = chunk->cache_buffer + chunk->cache_read_count * DVD_VIDEO_LB_LEN;
-    *buf = chunk->cache_buffer + (sector - chunk->cache_start_sector) * DVD_VIDEO_LB_LEN;
-    chunk->usage_count++;
+  if (!chunk->cache_valid || chunk->generation != generation) {
     pthread_mutex_unlock(&self->lock);
+    return 0;
+  }
 
-    dprintf("libdvdnav: sector=%d, start_sector=%d, last_sector=%d\n", sector, chunk->cache_start_sector, chunk->cache_start_sector + chunk->cache_block_count);
+  /* take whatever has already arrived beyond the minimum */
+  avail = chunk->cache_start_sector + chunk->cache_read_count - sector;
+  if (max_count > (size_t)avail)
+    max_count = avail;
+  *buf = chunk->cache_buffer + (sector - chunk->cache_start_sector) * DVD_VIDEO_LB_LEN;
+  chunk->usage_count++;
+  self->usage_count++;
+  self->stats.hits += max_count;
+  self->last_sector = sector + max_count - 1;
+  dprintf("libdvdnav: sector=%d, start_sector=%d, last_sector=%d\n", sector, chunk->cache_start_sector, chunk->cache_start_sector + chunk->cache_block_count);
+  pthread_mutex_unlock(&self->lock);
 
-    /* read_ahead_size */
-    incr = self->read_ahead_incr >> 1;
-    if ((self->read_ahead_size + incr) > READ_AHEAD_SIZE_MAX) {
-      self->read_ahead_size = READ_AHEAD_SIZE_MAX;
-    } else {
-      self->read_ahead_size += incr;
-    }
+  return max_count;
+}
 
-    /* real read size */
-    start = chunk->cache_start_sector + chunk->cache_read_count;
-    if (chunk->cache_read_count + self->read_ahead_size > chunk->cache_block_count) {
-      size = chunk->cache_block_count - chunk->cache_read_count;
-    } else {
-      size = self->read_ahead_size;
-      /* ensure that the sector we want will be read */
-      if (sector >= chunk->cache_start_sector + chunk->cache_read_count + size)
-        size = sector - chunk->cache_start_sector - chunk->cache_read_count;
-    }
-    dprintf("libdvdnav: read_ahead_size=%d, size=%d\n", self->read_ahead_size, size);
+int dvdnav_read_cache_block(read_cache_t *self, int sector, size_t block_count, uint8_t **buf) {
+  int count;
+  ssize_t res;
+  struct timeval tv;
 
-    if (size)
-      chunk->cache_read_count += DVDReadBlocks(self->dvd_self->file,
-                                               start,
-                                               size,
-                                               read_ahead_buf);
+  if(!self)
+    return 0;
 
-    res = DVD_VIDEO_LB_LEN * block_count;
+  if(self->dvd_self->use_read_ahead) {
+    count = read_cache_lookup(self, sector, block_count, block_count, buf);
+    if (count)
+      return DVD_VIDEO_LB_LEN * count;
+    dprintf("cache miss on sector %d\n", sector);
+  }
 
-  } else {
+  gettimeofday(&tv, NULL);
+  res = DVDReadBlocks(self->dvd_self->file,
+                      sector,
+                      block_count,
+                      *buf);
+  pthread_mutex_lock(&self->lock);
+  self->stats.misses += block_count;
+  read_cache_count_read(self, res, &tv);
+  pthread_mutex_unlock(&self->lock);
+
+  return res * DVD_VIDEO_LB_LEN;
+}
 
-    if (self->dvd_self->use_read_ahead)
-      dprintf("cache miss on sector %d\n", sector);
+int dvdnav_read_cache_span(read_cache_t *self, int sector, size_t max_blocks, uint8_t **buf) {
+  int count;
 
-    res = DVDReadBlocks(self->dvd_self->file,
-                        sector,
-                        block_count,
-                        *buf) * DVD_VIDEO_LB_LEN;
+  if(!self)
+    return 0;
+
+  if(self->dvd_self->use_read_ahead && max_blocks > 1) {
+    count = read_cache_lookup(self, sector, 1, max_blocks, buf);
+    if (count)
+      return DVD_VIDEO_LB_LEN * count;
   }
 
-  return res;
+  return dvdnav_read_cache_block(self, sector, 1, buf);
+}
 
+void dvdnav_read_cache_stats(read_cache_t *self, dvdnav_cache_stats_t *stats) {
+  int i;
+
+  pthread_mutex_lock(&self->lock);
+  *stats = self->stats;
+  stats->read_ahead_size = self->read_ahead_size;
+  stats->chunks = self->chunk_count;
+  stats->chunks_in_use = 0;
+  for (i = 0; i < self->chunk_count; i++)
+    if (self->chunk[i].usage_count)
+      stats->chunks_in_use++;
+  pthread_mutex_unlock(&self->lock);
 }
 
 dvdnav_status_t dvdnav_free_cache_block(dvdnav_t *self, unsigned char *buf) {
   read_cache_t *cache;
-  int i;
+  int use, freeing;
 
   if (!self)
     return DVDNAV_STATUS_ERR;
@@ -340,15 +755,15 @@ dvdnav_status_t dvdnav_free_cache_block(dvdnav_t *self, unsigned char *buf) {
     return DVDNAV_STATUS_ERR;
 
   pthread_mutex_lock(&cache->lock);
-  for (i = 0; i < READ_CACHE_CHUNKS; i++) {
-    if (cache->chunk[i].cache_buffer && buf >= cache->chunk[i].cache_buffer &&
-        buf < cache->chunk[i].cache_buffer + cache->chunk[i].cache_malloc_size * DVD_VIDEO_LB_LEN) {
-      cache->chunk[i].usage_count--;
-    }
+  use = read_cache_find_buffer(cache, buf);
+  if (use >= 0) {
+    cache->chunk[use].usage_count--;
+    cache->usage_count--;
   }
+  freeing = cache->freeing;
   pthread_mutex_unlock(&cache->lock);
 
-  if (cache->freeing)
+  if (freeing)
     /* when we want to dispose the cache, try freeing it now */
     dvdnav_read_cache_free(cache);
 
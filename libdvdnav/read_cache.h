@@ -27,16 +27,26 @@
 /* Opaque cache type -- defined in dvdnav_internal.h */
 /* typedef struct read_cache_s read_cache_t; */
 
-/* EXPERIMENTAL: Setting the following to 1 will use an experimental multi-threaded
- *               read-ahead cache.
+/* Setting the following to 1 does the read-ahead in background threads, so
+ * that slow seeks and drive spin-ups do not stall the reader. With 0 the
+ * read-ahead is done synchronously on the caller's thread.
  */
+#ifndef WIN32
+#define _MULTITHREAD_ 1
+#else
 #define _MULTITHREAD_ 0
+#endif
 
 /* Constructor/destructors */
 read_cache_t *dvdnav_read_cache_new(dvdnav_t* dvd_self);
 void dvdnav_read_cache_free(read_cache_t* self);
 
-/* This function MUST be called whenever self->file changes. */
+/* Sets the arena size limit and the sectors per chunk, 0 keeps the default.
+ * Returns 0 while buffers from the cache are still in use. */
+int dvdnav_read_cache_configure(read_cache_t *self, size_t max_bytes, size_t chunk_blocks);
+
+/* This function MUST be called whenever self->file changes, before the old
+ * file is closed. It waits for a pending read-ahead on that file to finish. */
 void dvdnav_read_cache_clear(read_cache_t *self);
 /* This function is called just after reading the NAV packet. */
 void dvdnav_pre_cache_blocks(read_cache_t *self, int sector, size_t block_count);
@@ -45,5 +55,12 @@ void dvdnav_pre_cache_blocks(read_cache_t *self, int sector, size_t block_count)
  * On a cache hit, a different buffer will be returned though.
  * Those buffers must _never_ be freed. */
 int dvdnav_read_cache_block(read_cache_t *self, int sector, size_t block_count, uint8_t **buf);
+/* Like dvdnav_read_cache_block(), but hands out as many of the next
+ * 'max_blocks' blocks as are contiguous in the cache and already read,
+ * at least one. The buffer handed in only has to take one block. */
+int dvdnav_read_cache_span(read_cache_t *self, int sector, size_t max_blocks, uint8_t **buf);
+
+/* Takes a consistent snapshot of the cache counters. */
+void dvdnav_read_cache_stats(read_cache_t *self, dvdnav_cache_stats_t *stats);
 
 #endif /* __DVDNAV_READ_CACHE_H */
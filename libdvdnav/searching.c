@@ -35,6 +35,7 @@
 #include "dvd_types.h"
 #include "nav_types.h"
 #include "ifo_types.h"
+#include "ifo_read.h"
 #include "remap.h"
 #include "decoder.h"
 #include "vm.h"
@@ -47,6 +48,22 @@
 
 /* Searching API calls */
 
+/* Return the VOBU address map of a domain, NULL if there is none. */
+static vobu_admap_t *dvdnav_get_admap(dvdnav_t *this, int32_t domain) {
+  switch(domain) {
+  case FP_DOMAIN:
+  case VMGM_DOMAIN:
+    return ifoGet_VOBU_ADMAP(this->vm->vmgi);
+  case VTSM_DOMAIN:
+    return ifoGet_VOBU_ADMAP(this->vm->vtsi);
+  case VTS_DOMAIN:
+    return ifoGet_TITLE_VOBU_ADMAP(this->vm->vtsi);
+  default:
+    fprintf(MSG_OUT, "libdvdnav: Error: Unknown domain for seeking.\n");
+  }
+  return NULL;
+}
+
 /* Scan the ADMAP for a particular block number. */
 /* Return placed in vobu. */
 /* Returns error status */
@@ -61,20 +78,7 @@ static dvdnav_status_t dvdnav_scan_admap(dvdnav_t *this, int32_t domain, uint32_
 
   /* Search through the VOBU_ADMAP for the nearest VOBU
    * to the target block */
-  switch(domain) {
-  case FP_DOMAIN:
-  case VMGM_DOMAIN:
-    admap = this->vm->vmgi->menu_vobu_admap;
-    break;
-  case VTSM_DOMAIN:
-    admap = this->vm->vtsi->menu_vobu_admap;
-    break;
-  case VTS_DOMAIN:
-    admap = this->vm->vtsi->vts_vobu_admap;
-    break;
-  default:
-    fprintf(MSG_OUT, "libdvdnav: Error: Unknown domain for seeking.\n");
-  }
+  admap = dvdnav_get_admap(this, domain);
   if(admap) {
     uint32_t address = 0;
     uint32_t vobu_start, next_vobu, first_address, last_address; 
@@ -309,7 +313,7 @@ dvdnav_status_t dvdnav_sector_search(dvdnav_t *this,
     cell =  &(state->pgc->cell_playback[cell_nr-1]);
     if(cell->block_type == BLOCK_TYPE_ANGLE_BLOCK && cell->block_mode != BLOCK_MODE_FIRST_CELL)
       continue;
-    length == cell->last_sector - cell->first_sector + 1;
+    length = cell->last_sector - cell->first_sector + 1;
     if (target >= length) {
       target -= length;
     } else {
@@ -522,6 +526,7 @@ dvdnav_status_t dvdnav_menu_call(dvdnav_t *this, DVDMenuID_t menu) {
 dvdnav_status_t dvdnav_get_position(dvdnav_t *this, uint32_t *pos,
 				    uint32_t *len) {
   uint32_t cur_sector;
+  uint32_t block_start;
   int32_t cell_nr, first_cell_nr, last_cell_nr;
   cell_playback_t *cell;
   dvd_state_t *state;
@@ -568,15 +573,24 @@ dvdnav_status_t dvdnav_get_position(dvdnav_t *this, uint32_t *pos,
       last_cell_nr = state->pgc->nr_of_cells;
   }
 
+  /* Only the first cell of an angle block counts, as in
+   * dvdnav_sector_search(), another angle takes its place. */
   *pos = -1;
   *len = 0;
+  block_start = 0;
   for (cell_nr = first_cell_nr; cell_nr <= last_cell_nr; cell_nr++) {
     cell = &(state->pgc->cell_playback[cell_nr-1]);
+    if (cell->block_type == BLOCK_TYPE_ANGLE_BLOCK && cell->block_mode != BLOCK_MODE_FIRST_CELL) {
+      if (cell_nr == state->cellN)
+        *pos = block_start + cur_sector - cell->first_sector;
+      continue;
+    }
     if (cell_nr == state->cellN) {
       /* the current sector is in this cell,
        * pos is length of PG up to here + sector's offset in this cell */
       *pos = *len + cur_sector - cell->first_sector;
     }
+    block_start = *len;
     *len += cell->last_sector - cell->first_sector + 1;
   }
 
@@ -715,6 +729,99 @@ dvdnav_status_t dvdnav_relative_time_search(dvdnav_t *this,
   return DVDNAV_STATUS_OK; 
 }
     
+uint32_t dvdnav_describe_pgc_vobus(dvdnav_t *this, uint32_t **vobus, uint32_t *length) {
+  uint32_t first_cell_nr, last_cell_nr, cell_nr;
+  uint32_t entries, first, last, mid, base, count, pass;
+  uint32_t *tmp = NULL;
+  cell_playback_t *cell;
+  vobu_admap_t *admap;
+  dvd_state_t *state;
+
+  *vobus = NULL;
+  *length = 0;
+  pthread_mutex_lock(&this->vm_lock);
+  if(!this->started) {
+    /* don't report an error but be nice */
+    vm_start(this->vm);
+    this->started = 1;
+  }
+  state = &(this->vm->state);
+  if(!state->pgc) {
+    printerr("No current PGC.");
+    goto fail;
+  }
+  admap = dvdnav_get_admap(this, state->domain);
+  if(!admap) {
+    printerr("No VOBU address map.");
+    goto fail;
+  }
+  entries = (admap->last_byte + 1 - VOBU_ADMAP_SIZE) / 4;
+
+  if (this->pgc_based) {
+    first_cell_nr = 1;
+    last_cell_nr = state->pgc->nr_of_cells;
+  } else {
+    /* Find start cell of program. */
+    first_cell_nr = state->pgc->program_map[state->pgN-1];
+    /* Find end cell of program */
+    if(state->pgN < state->pgc->nr_of_programs)
+      last_cell_nr = state->pgc->program_map[state->pgN] - 1;
+    else
+      last_cell_nr = state->pgc->nr_of_cells;
+  }
+
+  /* The first pass counts the VOBUs, the second one stores them. The cells
+   * are laid out one after the other, skipping the other angles, as in
+   * dvdnav_sector_search(). */
+  count = 0;
+  for(pass = 0; pass < 2; pass++) {
+    base = 0;
+    count = 0;
+    for(cell_nr = first_cell_nr; cell_nr <= last_cell_nr; cell_nr++) {
+      cell = &(state->pgc->cell_playback[cell_nr-1]);
+      if(cell->block_type == BLOCK_TYPE_ANGLE_BLOCK && cell->block_mode != BLOCK_MODE_FIRST_CELL)
+        continue;
+
+      /* the admap is sorted, find the cell's first VOBU */
+      first = 0;
+      last = entries;
+      while(first < last) {
+        mid = (first + last) / 2;
+        if(admap->vobu_start_sectors[mid] < cell->first_sector)
+          first = mid + 1;
+        else
+          last = mid;
+      }
+      for(; first < entries && admap->vobu_start_sectors[first] <= cell->last_sector; first++) {
+        if(tmp)
+          tmp[count] = base + admap->vobu_start_sectors[first] - cell->first_sector;
+        count++;
+      }
+      base += cell->last_sector - cell->first_sector + 1;
+    }
+    if(pass == 0) {
+      if(!count) {
+        printerr("No VOBUs in the current PGC.");
+        goto fail;
+      }
+      tmp = malloc(sizeof(uint32_t) * count);
+      if(!tmp) {
+        printerr("Out of memory.");
+        goto fail;
+      }
+    }
+  }
+
+  *vobus = tmp;
+  *length = base;
+  pthread_mutex_unlock(&this->vm_lock);
+  return count;
+
+fail:
+  pthread_mutex_unlock(&this->vm_lock);
+  return 0;
+}
+
 uint32_t dvdnav_describe_title_chapters(dvdnav_t *this, int32_t title, uint64_t **times, uint64_t *duration) {
   int32_t retval=0;
   uint16_t parts, i;
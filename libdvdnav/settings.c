@@ -37,6 +37,7 @@
 #include "vm.h"
 #include "dvdnav.h"
 #include "dvdnav_internal.h"
+#include "read_cache.h"
 
 /* Characteristics/setting API calls */
 
@@ -62,6 +63,41 @@ dvdnav_status_t dvdnav_get_readahead_flag(dvdnav_t *this, int32_t *flag) {
   return DVDNAV_STATUS_OK;
 }
 
+dvdnav_status_t dvdnav_set_cache_config(dvdnav_t *this, size_t max_bytes, size_t chunk_blocks) {
+  if(!this->cache) {
+    printerr("No read cache.");
+    return DVDNAV_STATUS_ERR;
+  }
+  if(!dvdnav_read_cache_configure(this->cache, max_bytes, chunk_blocks)) {
+    printerr("Cache buffers are still in use.");
+    return DVDNAV_STATUS_ERR;
+  }
+  return DVDNAV_STATUS_OK;
+}
+
+dvdnav_status_t dvdnav_get_cache_stats(dvdnav_t *this, dvdnav_cache_stats_t *stats) {
+  if(!this->cache) {
+    printerr("No read cache.");
+    return DVDNAV_STATUS_ERR;
+  }
+  dvdnav_read_cache_stats(this->cache, stats);
+  return DVDNAV_STATUS_OK;
+}
+
+dvdnav_status_t dvdnav_pre_cache(dvdnav_t *this, uint32_t block_count) {
+  pthread_mutex_lock(&this->vm_lock);
+  /* The VOBU is only known once its NAV packet was read, a jump clears
+   * its length until then. */
+  if(!this->started || !this->vobu.vobu_length) {
+    printerr("No VOBU read yet.");
+    pthread_mutex_unlock(&this->vm_lock);
+    return DVDNAV_STATUS_ERR;
+  }
+  dvdnav_pre_cache_blocks(this->cache, this->vobu.vobu_start + 1, block_count);
+  pthread_mutex_unlock(&this->vm_lock);
+  return DVDNAV_STATUS_OK;
+}
+
 static dvdnav_status_t set_language_register(dvdnav_t *this, char *code, int reg) {
   if(!code[0] || !code[1]) {
     printerr("Passed illegal language code.");